@@ -0,0 +1,13 @@
+CREATE TABLE IF NOT EXISTS `mod_reagent_bank_account_audit` (
+    `id` bigint unsigned NOT NULL AUTO_INCREMENT,
+    `time` int unsigned NOT NULL,
+    `account_id` int unsigned NOT NULL,
+    `guid` int unsigned NOT NULL,
+    `character_guid` int unsigned NOT NULL DEFAULT 0,
+    `item_entry` int unsigned NOT NULL,
+    `delta` int NOT NULL,
+    `operation` tinyint unsigned NOT NULL DEFAULT 0,
+    PRIMARY KEY (`id`),
+    KEY `idx_owner` (`account_id`, `guid`, `time`),
+    KEY `idx_time` (`time`)
+) ENGINE=InnoDB DEFAULT CHARSET=UTF8MB4;
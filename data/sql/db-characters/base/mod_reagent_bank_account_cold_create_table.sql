@@ -0,0 +1,15 @@
+CREATE TABLE IF NOT EXISTS `mod_reagent_bank_account_cold` (
+    `account_id` int unsigned NOT NULL DEFAULT 0,
+    `guid` int NOT NULL DEFAULT 0,
+    `item_entry` int NOT NULL,
+    `item_subclass` int NOT NULL,
+    `amount` int NOT NULL,
+    PRIMARY KEY (`account_id`, `guid`, `item_entry`)
+) ENGINE=InnoDB DEFAULT CHARSET=UTF8MB4 ROW_FORMAT=COMPRESSED;
+
+CREATE TABLE IF NOT EXISTS `mod_reagent_bank_account_activity` (
+    `account_id` int unsigned NOT NULL DEFAULT 0,
+    `guid` int NOT NULL DEFAULT 0,
+    `last_active` int unsigned NOT NULL,
+    PRIMARY KEY (`account_id`, `guid`)
+) ENGINE=InnoDB DEFAULT CHARSET=UTF8MB4;
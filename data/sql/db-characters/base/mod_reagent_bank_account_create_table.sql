@@ -1,5 +1,5 @@
 CREATE TABLE IF NOT EXISTS `mod_reagent_bank_account` (
-    `account_id` int NOT NULL DEFAULT 0,
+    `account_id` int unsigned NOT NULL DEFAULT 0,
     `guid` int NOT NULL DEFAULT 0,
     `item_entry` int NOT NULL,
     `item_subclass` int NOT NULL,
@@ -0,0 +1,9 @@
+CREATE TABLE IF NOT EXISTS `mod_reagent_bank_account_migration` (
+    `id` tinyint unsigned NOT NULL DEFAULT 1,
+    `direction` tinyint unsigned NOT NULL COMMENT '1 = into account rows, 2 = into character rows',
+    `cursor_key` int unsigned NOT NULL DEFAULT 0,
+    `owners_moved` int unsigned NOT NULL DEFAULT 0,
+    `owners_skipped` int unsigned NOT NULL DEFAULT 0,
+    `paused` tinyint unsigned NOT NULL DEFAULT 0,
+    PRIMARY KEY (`id`)
+) ENGINE=InnoDB DEFAULT CHARSET=UTF8MB4;
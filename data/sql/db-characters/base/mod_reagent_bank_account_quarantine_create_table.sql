@@ -0,0 +1,13 @@
+CREATE TABLE IF NOT EXISTS `mod_reagent_bank_account_quarantine` (
+    `id` bigint unsigned NOT NULL AUTO_INCREMENT,
+    `account_id` int unsigned NOT NULL DEFAULT 0,
+    `guid` int NOT NULL DEFAULT 0,
+    `item_entry` int NOT NULL,
+    `item_subclass` int NOT NULL,
+    `amount` int NOT NULL,
+    `reason` tinyint unsigned NOT NULL COMMENT '1 = unknown item, 2 = orphaned character (both restorable), 3 = debit shortfall (record only)',
+    `quarantined_at` int unsigned NOT NULL,
+    PRIMARY KEY (`id`),
+    KEY `idx_owner` (`account_id`, `guid`, `item_entry`),
+    KEY `idx_reason` (`reason`, `quarantined_at`)
+) ENGINE=InnoDB DEFAULT CHARSET=UTF8MB4;
@@ -0,0 +1,6 @@
+CREATE TABLE IF NOT EXISTS `mod_reagent_bank_account_restock` (
+    `guid` int NOT NULL,
+    `item_entry` int NOT NULL,
+    `target` int NOT NULL,
+    PRIMARY KEY (`guid`, `item_entry`)
+) ENGINE=InnoDB DEFAULT CHARSET=UTF8MB4;
@@ -0,0 +1,5 @@
+CREATE TABLE IF NOT EXISTS `mod_reagent_bank_account_settings` (
+    `guid` int NOT NULL,
+    `auto_deposit` tinyint NOT NULL DEFAULT 0,
+    PRIMARY KEY (`guid`)
+) ENGINE=InnoDB DEFAULT CHARSET=UTF8MB4;
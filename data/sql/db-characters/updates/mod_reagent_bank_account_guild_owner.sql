@@ -0,0 +1,3 @@
+-- Guild-shared banks are keyed as account_id = 0x80000000 | guildId
+ALTER TABLE `mod_reagent_bank_account`
+    MODIFY `account_id` int unsigned NOT NULL DEFAULT 0;
@@ -0,0 +1,9 @@
+-- One row per quarantine event, so debit shortfalls never merge into
+-- restorable rows of the same item
+ALTER TABLE `mod_reagent_bank_account_quarantine`
+    DROP PRIMARY KEY,
+    ADD `id` bigint unsigned NOT NULL AUTO_INCREMENT FIRST,
+    ADD PRIMARY KEY (`id`),
+    ADD KEY `idx_owner` (`account_id`, `guid`, `item_entry`),
+    ADD KEY `idx_reason` (`reason`, `quarantined_at`),
+    MODIFY `reason` tinyint unsigned NOT NULL COMMENT '1 = unknown item, 2 = orphaned character (both restorable), 3 = debit shortfall (record only)';
@@ -1,10 +1,121 @@
 #include "ReagentBankAccount.h"
+#include "Log.h"
+#include "ReagentBankAdmission.h"
+#include "ReagentBankAudit.h"
+#include "ReagentBankCategories.h"
+#include "ReagentBankMgr.h"
+#include "StringConvert.h"
+#include "WorldSession.h"
+#include "WorldSessionMgr.h"
 #include <algorithm>
 #include <cctype>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <tuple>
 #include <unordered_map>
 
-uint32 g_maxOptionsPerPage;
-bool g_accountWideReagentBank = false;
+static ReagentBankSettingsPtr s_settings =
+    std::make_shared<ReagentBankSettings const>();
+
+ReagentBankSettingsPtr GetReagentBankSettings()
+{
+  return std::atomic_load(&s_settings);
+}
+
+void LoadReagentBankConfig(bool reload)
+{
+  auto settings = std::make_shared<ReagentBankSettings>();
+  settings->maxOptionsPerPage = sConfigMgr->GetOption<uint32>(
+      "ReagentBankAccount.MaxOptionsPerPage", DEFAULT_MAX_OPTIONS);
+  settings->pageByteBudget = sConfigMgr->GetOption<uint32>(
+      "ReagentBankAccount.PageByteBudget", DEFAULT_PAGE_BYTE_BUDGET);
+  settings->accountWide =
+      sConfigMgr->GetOption<bool>("ReagentBankAccount.AccountWide", false);
+  settings->autoDeposit = sConfigMgr->GetOption<bool>(
+      "ReagentBankAccount.AutoDeposit.Enable", false);
+  settings->craftFromBank = sConfigMgr->GetOption<bool>(
+      "ReagentBankAccount.CraftFromBank.Enable", false);
+  settings->flushInterval = sConfigMgr->GetOption<uint32>(
+      "ReagentBankAccount.FlushInterval", DEFAULT_LEDGER_FLUSH_INTERVAL);
+  settings->guildShared =
+      sConfigMgr->GetOption<bool>("ReagentBankAccount.GuildShared", false);
+  settings->guildDailyWithdrawLimit = sConfigMgr->GetOption<uint32>(
+      "ReagentBankAccount.Guild.DailyWithdrawLimit", 0);
+  settings->archiveInactiveDays = sConfigMgr->GetOption<uint32>(
+      "ReagentBankAccount.Archive.InactiveDays", 0);
+  settings->rateLimitBurst = sConfigMgr->GetOption<uint32>(
+      "ReagentBankAccount.RateLimit.Burst", DEFAULT_RATE_LIMIT_BURST);
+  settings->rateLimitPerSecond = sConfigMgr->GetOption<uint32>(
+      "ReagentBankAccount.RateLimit.PerSecond", DEFAULT_RATE_LIMIT_PER_SECOND);
+  settings->repair =
+      sConfigMgr->GetOption<bool>("ReagentBankAccount.Repair.Enable", false);
+  settings->audit =
+      sConfigMgr->GetOption<bool>("ReagentBankAccount.Audit.Enable", false);
+  settings->auditRetentionDays = sConfigMgr->GetOption<uint32>(
+      "ReagentBankAccount.Audit.RetentionDays", DEFAULT_AUDIT_RETENTION_DAYS);
+  settings->transferDirectory = sConfigMgr->GetOption<std::string>(
+      "ReagentBankAccount.Transfer.Directory", DEFAULT_TRANSFER_DIRECTORY);
+
+  // Derived: a category page leaves room for its six surrounding options
+  if (settings->maxOptionsPerPage)
+    settings->pageRowLimit =
+        std::min(settings->pageRowLimit, settings->maxOptionsPerPage);
+
+  ReagentBankSettingsPtr current = std::move(settings);
+  ReagentBankSettingsPtr previous = std::atomic_exchange(&s_settings, current);
+  bool modeChanged = reload && (current->accountWide != previous->accountWide ||
+                                current->guildShared != previous->guildShared);
+
+  // Online characters switch to the bank of the new mode right away, so
+  // the ledger they hold and the keys their requests resolve to agree
+  if (modeChanged)
+  {
+    for (auto const &[accountId, session] :
+         sWorldSessionMgr->GetAllSessions())
+      if (Player *player = session->GetPlayer())
+        RefreshReagentBankOwner(player);
+    LOG_WARN("module",
+             "ReagentBankAccount: storage mode changed by a config reload; "
+             "online characters were switched to their new bank. Use "
+             ".reagentbank migrate to move existing reagents.");
+  }
+
+  if (reload)
+    LOG_INFO("module", "ReagentBankAccount: configuration reloaded");
+}
+
+// Helper to resolve the stored key pattern. We store either:
+//  account_id = <acct>, guid = 0   (account-wide mode)
+//  account_id = 0,      guid = <guid> (per-character mode)
+//  account_id = GUILD_OWNER_FLAG | <guildId>, guid = 0 (guild-shared mode,
+//  for characters in a guild)
+void GetStorageKeys(Player *player, uint32 &accountKey, uint32 &guidKey)
+{
+  GetStorageKeys(player, player->GetGuildId(), accountKey, guidKey);
+}
+
+void GetStorageKeys(Player *player, uint32 guildId, uint32 &accountKey,
+                    uint32 &guidKey)
+{
+  ReagentBankSettingsPtr settings = GetReagentBankSettings();
+  if (settings->guildShared && guildId)
+  {
+    accountKey = GUILD_OWNER_FLAG | guildId;
+    guidKey = 0;
+  }
+  else if (settings->accountWide)
+  {
+    accountKey = player->GetSession()->GetAccountId();
+    guidKey = 0;
+  }
+  else
+  {
+    accountKey = 0;
+    guidKey = player->GetGUID().GetRawValue();
+  }
+}
 
 // AzerothCore module: Account-wide Reagent Bank
 // This script adds a reagent bank NPC that allows players to deposit and
@@ -13,62 +124,46 @@ bool g_accountWideReagentBank = false;
 class mod_reagent_bank_account : public CreatureScript
 {
 private:
-  // Caches for item templates and icons
+  // Caches for item templates and icons. Gossip runs on map threads, so
+  // every cache of the script is behind a lock.
   mutable std::unordered_map<uint32, const ItemTemplate *> itemTemplateCache;
   mutable std::unordered_map<uint32, std::string> itemIconCache;
+  mutable std::mutex m_itemCacheLock;
   // Last viewed category + page per player (guidLow -> (category, page))
-  mutable std::unordered_map<uint32, std::pair<uint32, uint16>> m_lastCategoryPage;
+  std::unordered_map<uint32, std::pair<uint32, uint16>> m_lastCategoryPage;
+  std::mutex m_lastCategoryPageLock;
+
+  // A category listing rendered and cut into pages, reused across page
+  // flips while the stored entries and the page settings are unchanged
+  struct CategoryPages
+  {
+    std::vector<ReagentBankEntry> entries; // By item entry, for validation
+    uint32 maxRows;
+    uint32 pageByteBudget;
+    uint32 totalAmount;
+    std::vector<uint32> itemEntries;       // Display order
+    std::vector<std::string> rows;
+    std::vector<uint32> pageStarts;
+  };
+  // (account_id, guid, category, locale) -> listing; shared by the
+  // characters of an owner and reset when it grows past
+  // PAGE_CACHE_MAX_ENTRIES. Gossip runs on map threads, hence the lock.
+  typedef std::tuple<uint32, uint32, uint32, int> PageCacheKey;
+  std::map<PageCacheKey, std::shared_ptr<CategoryPages const>> m_pageCache;
+  std::mutex m_pageCacheLock;
 
   // Action codes for item-specific withdraw submenu
   static constexpr uint32 ACTION_WITHDRAW_ONE = 900001;
   static constexpr uint32 ACTION_WITHDRAW_STACK = 900002;
   static constexpr uint32 ACTION_WITHDRAW_ALL = 900003;
-
-  // Helper to resolve the stored key pattern. We store either:
-  //  account_id = <acct>, guid = 0   (account-wide mode)
-  //  account_id = 0,      guid = <guid> (per-character mode)
-  void GetStorageKeys(Player *player, uint32 &accountKey, uint32 &guidKey) const
-  {
-    if (g_accountWideReagentBank)
-    {
-      accountKey = player->GetSession()->GetAccountId();
-      guidKey = 0;
-    }
-    else
-    {
-      accountKey = 0;
-      guidKey = player->GetGUID().GetRawValue();
-    }
-  }
-
-  bool IsCategory(uint32 value) const
-  {
-    switch (value)
-    {
-    case ITEM_SUBCLASS_CLOTH:
-    case ITEM_SUBCLASS_MEAT:
-    case ITEM_SUBCLASS_METAL_STONE:
-    case ITEM_SUBCLASS_ENCHANTING:
-    case ITEM_SUBCLASS_ELEMENTAL:
-    case ITEM_SUBCLASS_PARTS:
-    case ITEM_SUBCLASS_TRADE_GOODS_OTHER:
-    case ITEM_SUBCLASS_HERB:
-    case ITEM_SUBCLASS_LEATHER:
-    case ITEM_SUBCLASS_JEWELCRAFTING:
-    case ITEM_SUBCLASS_EXPLOSIVES:
-    case ITEM_SUBCLASS_DEVICES:
-    case ITEM_SUBCLASS_MATERIAL:
-    case ITEM_SUBCLASS_ARMOR_ENCHANTMENT:
-    case ITEM_SUBCLASS_WEAPON_ENCHANTMENT:
-      return true;
-    default:
-      return false;
-    }
-  }
+  // Action codes for restock profile editing (action stores the item entry)
+  static constexpr uint32 ACTION_RESTOCK_SET = 900004;
+  static constexpr uint32 ACTION_RESTOCK_CLEAR = 900005;
 
   // Get and cache ItemTemplate
   const ItemTemplate *GetCachedItemTemplate(uint32 entry) const
   {
+    std::lock_guard<std::mutex> guard(m_itemCacheLock);
     auto it = itemTemplateCache.find(entry);
     if (it != itemTemplateCache.end())
       return it->second;
@@ -81,9 +176,12 @@ private:
   std::string GetCachedItemIcon(uint32 entry, uint32 width, uint32 height,
                                 int x, int y) const
   {
-    auto it = itemIconCache.find(entry);
-    if (it != itemIconCache.end())
-      return it->second;
+    {
+      std::lock_guard<std::mutex> guard(m_itemCacheLock);
+      auto it = itemIconCache.find(entry);
+      if (it != itemIconCache.end())
+        return it->second;
+    }
     std::ostringstream ss;
     ss << "|TInterface";
     const ItemTemplate *temp = GetCachedItemTemplate(entry);
@@ -98,7 +196,8 @@ private:
       ss << "/InventoryItems/WoWUnknownItem01";
     ss << ":" << width << ":" << height << ":" << x << ":" << y << "|t";
     std::string iconStr = ss.str();
-    itemIconCache[entry] = iconStr;
+    std::lock_guard<std::mutex> guard(m_itemCacheLock);
+    itemIconCache.emplace(entry, iconStr);
     return iconStr;
   }
 
@@ -132,200 +231,47 @@ private:
     return oss.str();
   }
 
-  // Withdraws a stack or all of a reagent from the account-wide bank for the
-  // player
-  void WithdrawItem(Player *player, uint32 entry)
+  // Withdraws up to `wanted` of one reagent and reports the result
+  void WithdrawAmount(Player *player, uint32 entry, uint32 wanted)
   {
-    uint32 accountKey, guidKey;
-    GetStorageKeys(player, accountKey, guidKey);
-    QueryResult result = CharacterDatabase.Query(
-        "SELECT amount FROM mod_reagent_bank_account WHERE account_id = {} AND guid = {} AND item_entry = {}",
-        accountKey, guidKey, entry);
-    if (result)
-    {
-      uint32 storedAmount = (*result)[0].Get<uint32>();
-      const ItemTemplate *temp = sObjectMgr->GetItemTemplate(entry);
-      if (!temp)
-      {
-        ChatHandler(player->GetSession())
-            .PSendSysMessage("Error: Item template not found for entry {}.",
-                             entry);
-        return;
-      }
-      uint32 stackSize = temp->GetMaxStackSize();
-      if (storedAmount <= stackSize)
-      {
-        // Give the player all of the item and remove it from the DB
-        ItemPosCountVec dest;
-        InventoryResult msg = player->CanStoreNewItem(NULL_BAG, NULL_SLOT, dest,
-                                                      entry, storedAmount);
-        if (msg == EQUIP_ERR_OK)
-        {
-          CharacterDatabase.DirectExecute(
-              "DELETE FROM mod_reagent_bank_account WHERE account_id = {} AND guid = {} AND item_entry = {}",
-              accountKey, guidKey, entry);
-          Item *item = player->StoreNewItem(dest, entry, true);
-          player->SendNewItem(item, storedAmount, true, false);
-          ChatHandler(player->GetSession())
-              .PSendSysMessage("Withdrew {} x {}.", storedAmount,
-                               temp->Name1);
-        }
-        else
-        {
-          player->SendEquipError(msg, nullptr, nullptr, entry);
-          ChatHandler(player->GetSession())
-              .PSendSysMessage("Not enough bag space to withdraw {} x {}.",
-                               storedAmount, temp->Name1);
-          return;
-        }
-      }
-      else
-      {
-        // Give the player a single stack
-        ItemPosCountVec dest;
-        InventoryResult msg = player->CanStoreNewItem(NULL_BAG, NULL_SLOT, dest,
-                                                      entry, stackSize);
-        if (msg == EQUIP_ERR_OK)
-        {
-          CharacterDatabase.DirectExecute(
-              "UPDATE mod_reagent_bank_account SET amount = {} WHERE account_id = {} AND guid = {} AND item_entry = {}",
-              storedAmount - stackSize, accountKey, guidKey, entry);
-          Item *item = player->StoreNewItem(dest, entry, true);
-          player->SendNewItem(item, stackSize, true, false);
-          ChatHandler(player->GetSession())
-              .PSendSysMessage("Withdrew {} x {}.", stackSize,
-                               temp->Name1);
-        }
-        else
-        {
-          player->SendEquipError(msg, nullptr, nullptr, entry);
-          ChatHandler(player->GetSession())
-              .PSendSysMessage("Not enough bag space to withdraw {} x {}.",
-                               stackSize, temp->Name1);
-          return;
-        }
-      }
-    }
+    const ItemTemplate *temp = GetCachedItemTemplate(entry);
+    if (!temp || wanted == 0)
+      return;
+    std::map<uint32, uint32> withdrawn;
+    InventoryResult msg =
+        sReagentBankMgr->Withdraw(player, {{entry, wanted}}, withdrawn);
+    uint32 givenTotal = withdrawn.count(entry) ? withdrawn[entry] : 0;
+    if (givenTotal > 0)
+      ChatHandler(player->GetSession()).PSendSysMessage("Withdrew {} x {}.", givenTotal, temp->Name1);
+    if (msg != EQUIP_ERR_OK)
+      ChatHandler(player->GetSession()).PSendSysMessage("Not enough bag space to withdraw {} x {}.", wanted - givenTotal, temp->Name1);
   }
 
   // Withdraw one unit regardless of stack size
   void WithdrawOne(Player *player, uint32 entry)
   {
-    uint32 accountKey, guidKey;
-    GetStorageKeys(player, accountKey, guidKey);
-    QueryResult result = CharacterDatabase.Query(
-        "SELECT amount FROM mod_reagent_bank_account WHERE account_id = {} AND guid = {} AND item_entry = {}",
-        accountKey, guidKey, entry);
-    if (!result)
-      return;
-    uint32 stored = (*result)[0].Get<uint32>();
-    if (stored == 0)
-      return;
-    const ItemTemplate *temp = sObjectMgr->GetItemTemplate(entry);
-    if (!temp)
-      return;
-    ItemPosCountVec dest;
-    InventoryResult msg = player->CanStoreNewItem(NULL_BAG, NULL_SLOT, dest, entry, 1);
-    if (msg != EQUIP_ERR_OK)
-    {
-      player->SendEquipError(msg, nullptr, nullptr, entry);
-      ChatHandler(player->GetSession()).PSendSysMessage("Not enough space to withdraw 1 x {}.", temp->Name1);
-      return;
-    }
-    if (stored == 1)
-      CharacterDatabase.DirectExecute("DELETE FROM mod_reagent_bank_account WHERE account_id = {} AND guid = {} AND item_entry = {}", accountKey, guidKey, entry);
-    else
-      CharacterDatabase.DirectExecute("UPDATE mod_reagent_bank_account SET amount = {} WHERE account_id = {} AND guid = {} AND item_entry = {}", stored - 1, accountKey, guidKey, entry);
-    Item *item = player->StoreNewItem(dest, entry, true);
-    player->SendNewItem(item, 1, true, false);
-    ChatHandler(player->GetSession()).PSendSysMessage("Withdrew 1 x {}.", temp->Name1);
+    WithdrawAmount(player, entry, 1);
   }
 
   // Withdraw up to one full stack (or remaining if smaller)
   void WithdrawStack(Player *player, uint32 entry)
   {
-    uint32 accountKey, guidKey;
-    GetStorageKeys(player, accountKey, guidKey);
-    QueryResult result = CharacterDatabase.Query(
-        "SELECT amount FROM mod_reagent_bank_account WHERE account_id = {} AND guid = {} AND item_entry = {}",
-        accountKey, guidKey, entry);
-    if (!result)
-      return;
-    uint32 stored = (*result)[0].Get<uint32>();
-    if (stored == 0)
-      return;
-    const ItemTemplate *temp = sObjectMgr->GetItemTemplate(entry);
+    const ItemTemplate *temp = GetCachedItemTemplate(entry);
     if (!temp)
       return;
-    uint32 stackSize = temp->GetMaxStackSize();
-    uint32 toGive = std::min(stackSize, stored);
-    ItemPosCountVec dest;
-    InventoryResult msg = player->CanStoreNewItem(NULL_BAG, NULL_SLOT, dest, entry, toGive);
-    if (msg != EQUIP_ERR_OK)
-    {
-      player->SendEquipError(msg, nullptr, nullptr, entry);
-      ChatHandler(player->GetSession()).PSendSysMessage("Not enough space to withdraw {} x {}.", toGive, temp->Name1);
-      return;
-    }
-    if (toGive == stored)
-      CharacterDatabase.DirectExecute("DELETE FROM mod_reagent_bank_account WHERE account_id = {} AND guid = {} AND item_entry = {}", accountKey, guidKey, entry);
-    else
-      CharacterDatabase.DirectExecute("UPDATE mod_reagent_bank_account SET amount = {} WHERE account_id = {} AND guid = {} AND item_entry = {}", stored - toGive, accountKey, guidKey, entry);
-    Item *item = player->StoreNewItem(dest, entry, true);
-    player->SendNewItem(item, toGive, true, false);
-    ChatHandler(player->GetSession()).PSendSysMessage("Withdrew {} x {}.", toGive, temp->Name1);
+    WithdrawAmount(player, entry, temp->GetMaxStackSize());
   }
 
   // Withdraw all (multiple stacks as needed)
   void WithdrawAllOfItem(Player *player, uint32 entry)
   {
-    uint32 accountKey, guidKey;
-    GetStorageKeys(player, accountKey, guidKey);
-    QueryResult result = CharacterDatabase.Query(
-        "SELECT amount FROM mod_reagent_bank_account WHERE account_id = {} AND guid = {} AND item_entry = {}",
-        accountKey, guidKey, entry);
-    if (!result)
-      return;
-    uint32 remaining = (*result)[0].Get<uint32>();
-    if (remaining == 0)
-      return;
-    const ItemTemplate *temp = sObjectMgr->GetItemTemplate(entry);
-    if (!temp)
-      return;
-    uint32 stackSize = temp->GetMaxStackSize();
-    uint32 givenTotal = 0;
-    while (remaining > 0)
-    {
-      uint32 toGive = std::min(stackSize, remaining);
-      ItemPosCountVec dest;
-      InventoryResult msg = player->CanStoreNewItem(NULL_BAG, NULL_SLOT, dest, entry, toGive);
-      if (msg != EQUIP_ERR_OK)
-      {
-        player->SendEquipError(msg, nullptr, nullptr, entry);
-        ChatHandler(player->GetSession()).PSendSysMessage("Bag full after withdrawing {} x {} (remaining {}).", givenTotal, temp->Name1, remaining);
-        break;
-      }
-      Item *item = player->StoreNewItem(dest, entry, true);
-      player->SendNewItem(item, toGive, true, false);
-      givenTotal += toGive;
-      remaining -= toGive;
-    }
-    if (remaining == 0)
-      CharacterDatabase.DirectExecute("DELETE FROM mod_reagent_bank_account WHERE account_id = {} AND guid = {} AND item_entry = {}", accountKey, guidKey, entry);
-    else
-      CharacterDatabase.DirectExecute("UPDATE mod_reagent_bank_account SET amount = {} WHERE account_id = {} AND guid = {} AND item_entry = {}", remaining, accountKey, guidKey, entry);
-    if (givenTotal > 0)
-      ChatHandler(player->GetSession()).PSendSysMessage("Withdrew {} x {}.", givenTotal, temp->Name1);
+    ReagentBankOwner owner = sReagentBankMgr->GetOwner(player);
+    WithdrawAmount(player, entry, sReagentBankMgr->GetAmount(owner, entry));
   }
 
   void ShowItemWithdrawMenu(Player *player, Creature *creature, uint32 category, uint16 pageIndex, uint32 itemEntry)
   {
-    uint32 accountKey, guidKey;
-    GetStorageKeys(player, accountKey, guidKey);
-    QueryResult result = CharacterDatabase.Query(
-        "SELECT amount FROM mod_reagent_bank_account WHERE account_id = {} AND guid = {} AND item_entry = {}",
-        accountKey, guidKey, itemEntry);
-    uint32 stored = result ? (*result)[0].Get<uint32>() : 0;
+    uint32 stored = sReagentBankMgr->GetAmount(sReagentBankMgr->GetOwner(player), itemEntry);
     const ItemTemplate *temp = sObjectMgr->GetItemTemplate(itemEntry);
     std::string name = temp ? temp->Name1 : "Unknown";
     player->PlayerTalkClass->ClearMenus();
@@ -341,327 +287,302 @@ private:
       AddGossipItemFor(player, GOSSIP_ICON_NONE, "Withdraw Stack", ACTION_WITHDRAW_STACK, itemEntry);
     if (stored > 0)
       AddGossipItemFor(player, GOSSIP_ICON_NONE, "Withdraw All", ACTION_WITHDRAW_ALL, itemEntry);
+    uint32 target = GetRestockTarget(player, itemEntry);
+    AddGossipItemFor(player, GOSSIP_ICON_NONE, "Set Restock Target (current: " + std::to_string(target) + ")", ACTION_RESTOCK_SET, itemEntry, "Quantity to keep in your bags (0 removes it from the profile):", 0, true);
+    if (target > 0)
+      AddGossipItemFor(player, GOSSIP_ICON_NONE, "Remove From Restock Profile", ACTION_RESTOCK_CLEAR, itemEntry);
     AddGossipItemFor(player, GOSSIP_ICON_NONE, "Back", category, pageIndex);
     SendGossipMenuFor(player, NPC_TEXT_ID, creature->GetGUID());
   }
 
-  // Updates the item count maps and removes the item from the player's
-  // inventory
-  void UpdateItemCount(std::map<uint32, uint32> &entryToAmountMap,
-                       std::map<uint32, uint32> &entryToSubclassMap,
-                       std::map<uint32, uint32> &itemsAddedMap, Item *pItem,
-                       Player *player, uint32 bagSlot, uint32 itemSlot)
+  // Collects the reagents in the player's backpack and bags, optionally
+  // limited to one category
+  std::vector<Item *> CollectBagReagents(Player *player, uint32 item_subclass,
+                                         bool allCategories) const
   {
-    uint32 count = pItem->GetCount();
-    ItemTemplate const *itemTemplate = pItem->GetTemplate();
-
-    // Only allow trade goods and gems, and skip unique items
-    if (!(itemTemplate->Class == ITEM_CLASS_TRADE_GOODS ||
-          itemTemplate->Class == ITEM_CLASS_GEM) ||
-        itemTemplate->GetMaxStackSize() == 1)
-      return;
-    uint32 itemEntry = itemTemplate->ItemId;
-    uint32 itemSubclass = itemTemplate->SubClass;
-
-    // Put gems to ITEM_SUBCLASS_JEWELCRAFTING section
-    if (itemTemplate->Class == ITEM_CLASS_GEM)
+    std::vector<Item *> items;
+    auto collect = [&](Item *pItem)
     {
-      itemSubclass = ITEM_SUBCLASS_JEWELCRAFTING;
-    }
-
-    // Update or add to the amount and subclass maps
-    if (!entryToAmountMap.count(itemEntry))
+      ItemTemplate const *itemTemplate = pItem->GetTemplate();
+      if (IsReagent(itemTemplate) &&
+          (allCategories || GetReagentSubclass(itemTemplate) == item_subclass))
+        items.push_back(pItem);
+    };
+    // Inventory Items
+    for (uint8 i = INVENTORY_SLOT_ITEM_START; i < INVENTORY_SLOT_ITEM_END;
+         ++i)
     {
-      entryToAmountMap[itemEntry] = count;
-      entryToSubclassMap[itemEntry] = itemSubclass;
+      if (Item *pItem = player->GetItemByPos(INVENTORY_SLOT_BAG_0, i))
+        collect(pItem);
     }
-    else
+    // Bag Items
+    for (uint32 i = INVENTORY_SLOT_BAG_START; i < INVENTORY_SLOT_BAG_END; i++)
     {
-      uint32 existingCount = entryToAmountMap.find(itemEntry)->second;
-      entryToAmountMap[itemEntry] = existingCount + count;
+      Bag *bag = player->GetBagByPos(i);
+      if (!bag)
+        continue;
+      for (uint32 j = 0; j < bag->GetBagSize(); j++)
+      {
+        if (Item *pItem = player->GetItemByPos(i, j))
+          collect(pItem);
+      }
     }
+    return items;
+  }
 
-    // Track what was deposited for feedback
-    if (!itemsAddedMap.count(itemEntry))
+  // Deposits the given items and reports what was deposited
+  void DepositAndReport(Player *player, std::vector<Item *> const &items,
+                        std::string const &emptyMessage)
+  {
+    std::map<uint32, uint32> itemsAddedMap =
+        sReagentBankMgr->DepositItems(player, items);
+    if (itemsAddedMap.empty())
     {
-      itemsAddedMap[itemEntry] = count;
+      ChatHandler(player->GetSession()).SendSysMessage(emptyMessage);
+      return;
     }
-    else
+
+    // Feedback to player
+    ChatHandler(player->GetSession())
+        .SendSysMessage("The following was deposited:");
+    for (std::pair<uint32, uint32> mapEntry : itemsAddedMap)
     {
-      uint32 existingCount = itemsAddedMap.find(itemEntry)->second;
-      itemsAddedMap[itemEntry] = existingCount + count;
+      uint32 itemEntry = mapEntry.first;
+      uint32 itemAmount = mapEntry.second;
+      ItemTemplate const *itemTemplate = GetCachedItemTemplate(itemEntry);
+      std::string itemName = itemTemplate->Name1;
+      ChatHandler(player->GetSession())
+          .SendSysMessage(std::to_string(itemAmount) + " " + itemName);
     }
-
-    // Remove the item from the player's inventory
-    player->DestroyItem(bagSlot, itemSlot, true);
   }
 
   // Deposits all reagents from the player's bags into the account-wide bank
   void DepositAllReagents(Player *player)
   {
-    WorldSession *session = player->GetSession();
-    uint32 accountKey, guidKey;
-    GetStorageKeys(player, accountKey, guidKey);
-    std::string query = "SELECT item_entry, item_subclass, amount FROM mod_reagent_bank_account WHERE account_id = " + std::to_string(accountKey) + " AND guid = " + std::to_string(guidKey);
-    session->GetQueryProcessor().AddCallback(
-        CharacterDatabase.AsyncQuery(query).WithCallback(
-            [=, this](QueryResult result)
-            {
-              std::map<uint32, uint32> entryToAmountMap;
-              std::map<uint32, uint32> entryToSubclassMap;
-              std::map<uint32, uint32> itemsAddedMap;
-              if (result)
-              {
-                do
-                {
-                  uint32 itemEntry = (*result)[0].Get<uint32>();
-                  uint32 itemSubclass = (*result)[1].Get<uint32>();
-                  uint32 itemAmount = (*result)[2].Get<uint32>();
-                  entryToAmountMap[itemEntry] = itemAmount;
-                  entryToSubclassMap[itemEntry] = itemSubclass;
-                } while (result->NextRow());
-              }
-              // Inventory Items
-              for (uint8 i = INVENTORY_SLOT_ITEM_START;
-                   i < INVENTORY_SLOT_ITEM_END; ++i)
-              {
-                if (Item *pItem =
-                        player->GetItemByPos(INVENTORY_SLOT_BAG_0, i))
-                {
-                  UpdateItemCount(entryToAmountMap, entryToSubclassMap,
-                                  itemsAddedMap, pItem, player,
-                                  INVENTORY_SLOT_BAG_0, i);
-                }
-              }
-              // Bag Items
-              for (uint32 i = INVENTORY_SLOT_BAG_START;
-                   i < INVENTORY_SLOT_BAG_END; i++)
-              {
-                Bag *bag = player->GetBagByPos(i);
-                if (!bag)
-                  continue;
-                for (uint32 j = 0; j < bag->GetBagSize(); j++)
-                {
-                  if (Item *pItem = player->GetItemByPos(i, j))
-                  {
-                    UpdateItemCount(entryToAmountMap, entryToSubclassMap,
-                                    itemsAddedMap, pItem, player, i, j);
-                  }
-                }
-              }
-              // Write all changes to the DB in a transaction
-              if (entryToAmountMap.size() != 0)
-              {
-                auto trans = CharacterDatabase.BeginTransaction();
-                for (std::pair<uint32, uint32> mapEntry : entryToAmountMap)
-                {
-                  uint32 itemEntry = mapEntry.first;
-                  uint32 itemAmount = mapEntry.second;
-                  uint32 itemSubclass =
-                      entryToSubclassMap.find(itemEntry)->second;
-                  trans->Append("REPLACE INTO mod_reagent_bank_account (account_id, guid, item_entry, item_subclass, amount) VALUES ({}, {}, {}, {}, {})",
-                                accountKey, guidKey, itemEntry, itemSubclass, itemAmount);
-                }
-                CharacterDatabase.CommitTransaction(
-                    trans); // <-- just call, don't check return value
-              }
-              // Feedback to player
-              if (itemsAddedMap.size() != 0)
-              {
-                ChatHandler(player->GetSession())
-                    .SendSysMessage("The following was deposited:");
-                for (std::pair<uint32, uint32> mapEntry : itemsAddedMap)
-                {
-                  uint32 itemEntry = mapEntry.first;
-                  uint32 itemAmount = mapEntry.second;
-                  ItemTemplate const *itemTemplate =
-                      sObjectMgr->GetItemTemplate(itemEntry);
-                  std::string itemName = itemTemplate->Name1;
-                  ChatHandler(player->GetSession())
-                      .SendSysMessage(std::to_string(itemAmount) + " " +
-                                      itemName);
-                }
-              }
-              else
-              {
-                ChatHandler(player->GetSession())
-                    .PSendSysMessage("No reagents to deposit.");
-              }
-            }));
-
+    DepositAndReport(player, CollectBagReagents(player, 0, true),
+                     "No reagents to deposit.");
     CloseGossipMenuFor(player);
   }
 
   void DepositAllReagentsForCategory(Player *player, uint32 item_subclass)
   {
-    uint32 accountKey, guidKey;
-    GetStorageKeys(player, accountKey, guidKey);
+    DepositAndReport(player, CollectBagReagents(player, item_subclass, false),
+                     "No reagents to deposit in this category.");
+    CloseGossipMenuFor(player);
+  }
 
-    std::map<uint32, uint32> entryToAmountMap;
-    std::map<uint32, uint32> entryToSubclassMap;
-    std::map<uint32, uint32> itemsAddedMap;
+  // Reports a bulk withdrawal; returns false if nothing was withdrawn
+  bool ReportWithdrawals(Player *player,
+                         std::map<uint32, uint32> const &withdrawn,
+                         InventoryResult msg)
+  {
+    for (std::pair<uint32, uint32> mapEntry : withdrawn)
+    {
+      const ItemTemplate *temp = GetCachedItemTemplate(mapEntry.first);
+      ChatHandler(player->GetSession())
+          .PSendSysMessage("Withdrew {} x {}.", mapEntry.second,
+                           temp ? temp->Name1 : "Unknown");
+    }
+    if (msg != EQUIP_ERR_OK)
+      ChatHandler(player->GetSession())
+          .PSendSysMessage("Not enough bag space to withdraw the rest.");
+    return !withdrawn.empty();
+  }
 
-    // Inventory Items
-    for (uint8 i = INVENTORY_SLOT_ITEM_START; i < INVENTORY_SLOT_ITEM_END;
-         ++i)
+  // Helper: Withdraw all items in a category for the player
+  void WithdrawAllInCategory(Player *player, uint32 item_subclass)
+  {
+    std::vector<ReagentBankEntry> entries = sReagentBankMgr->ListByCategory(
+        sReagentBankMgr->GetOwner(player), item_subclass);
+    if (entries.empty())
     {
-      if (Item *pItem = player->GetItemByPos(INVENTORY_SLOT_BAG_0, i))
-      {
-        ItemTemplate const *itemTemplate = pItem->GetTemplate();
-        uint32 subclass = (itemTemplate->Class == ITEM_CLASS_GEM)
-                              ? ITEM_SUBCLASS_JEWELCRAFTING
-                              : itemTemplate->SubClass;
-        if ((itemTemplate->Class == ITEM_CLASS_TRADE_GOODS ||
-             itemTemplate->Class == ITEM_CLASS_GEM) &&
-            itemTemplate->GetMaxStackSize() > 1 && subclass == item_subclass)
-        {
-          UpdateItemCount(entryToAmountMap, entryToSubclassMap, itemsAddedMap,
-                          pItem, player, INVENTORY_SLOT_BAG_0, i);
-        }
-      }
+      ChatHandler(player->GetSession())
+          .PSendSysMessage("No reagents to withdraw in this category.");
+      return;
     }
-    // Bag Items
-    for (uint32 i = INVENTORY_SLOT_BAG_START; i < INVENTORY_SLOT_BAG_END; i++)
+
+    std::map<uint32, uint32> requests;
+    for (ReagentBankEntry const &entry : entries)
+      requests[entry.itemEntry] = entry.amount;
+    std::map<uint32, uint32> withdrawn;
+    InventoryResult msg = sReagentBankMgr->Withdraw(player, requests, withdrawn);
+    if (!ReportWithdrawals(player, withdrawn, msg))
+      ChatHandler(player->GetSession())
+          .PSendSysMessage("No reagents withdrawn.");
+  }
+
+  // Withdraws everything in every category with one listing and one bulk
+  // withdrawal
+  void WithdrawAllReagents(Player *player)
+  {
+    std::map<uint32, uint32> requests;
+    for (ReagentBankEntry const &entry :
+         sReagentBankMgr->ListAll(sReagentBankMgr->GetOwner(player)))
+      if (IsReagentCategory(entry.itemSubclass))
+        requests[entry.itemEntry] = entry.amount;
+    if (requests.empty())
     {
-      Bag *bag = player->GetBagByPos(i);
-      if (!bag)
-        continue;
-      for (uint32 j = 0; j < bag->GetBagSize(); j++)
-      {
-        if (Item *pItem = player->GetItemByPos(i, j))
-        {
-          ItemTemplate const *itemTemplate = pItem->GetTemplate();
-          uint32 subclass = (itemTemplate->Class == ITEM_CLASS_GEM)
-                                ? ITEM_SUBCLASS_JEWELCRAFTING
-                                : itemTemplate->SubClass;
-          if ((itemTemplate->Class == ITEM_CLASS_TRADE_GOODS ||
-               itemTemplate->Class == ITEM_CLASS_GEM) &&
-              itemTemplate->GetMaxStackSize() > 1 &&
-              subclass == item_subclass)
-          {
-            UpdateItemCount(entryToAmountMap, entryToSubclassMap, itemsAddedMap,
-                            pItem, player, i, j);
-          }
-        }
-      }
+      ChatHandler(player->GetSession())
+          .PSendSysMessage("No reagents to withdraw.");
+      return;
     }
-    // Write all changes to the DB in a transaction
-    if (entryToAmountMap.size() != 0)
+    std::map<uint32, uint32> withdrawn;
+    InventoryResult msg = sReagentBankMgr->Withdraw(player, requests, withdrawn);
+    if (!ReportWithdrawals(player, withdrawn, msg))
+      ChatHandler(player->GetSession())
+          .PSendSysMessage("No reagents withdrawn.");
+  }
+
+  // Sets the quantity of an item to keep in the bags; 0 removes the entry
+  void SetRestockTarget(Player *player, uint32 entry, uint32 target)
+  {
+    const ItemTemplate *temp = GetCachedItemTemplate(entry);
+    if (!temp)
+      return;
+    if (!UpdateRestockProfile(player, entry, target))
     {
-      auto trans = CharacterDatabase.BeginTransaction();
-      for (std::pair<uint32, uint32> mapEntry : entryToAmountMap)
-      {
-        uint32 itemEntry = mapEntry.first;
-        uint32 itemAmount = mapEntry.second;
-        uint32 itemSubclass = entryToSubclassMap.find(itemEntry)->second;
-        trans->Append("REPLACE INTO mod_reagent_bank_account (account_id, guid, item_entry, item_subclass, amount) VALUES ({}, {}, {}, {}, {})",
-                      accountKey, guidKey, itemEntry, itemSubclass, itemAmount);
-      }
-      CharacterDatabase.CommitTransaction(trans);
+      ChatHandler(player->GetSession())
+          .PSendSysMessage("Your restock profile is full ({} items).",
+                           MAX_RESTOCK_ENTRIES);
+      return;
     }
-    // Feedback to player
-    if (itemsAddedMap.size() != 0)
+    if (target == 0)
+      ChatHandler(player->GetSession())
+          .PSendSysMessage("Removed {} from your restock profile.", temp->Name1);
+    else
+      ChatHandler(player->GetSession())
+          .PSendSysMessage("Restock target for {} set to {}.", temp->Name1,
+                           target);
+  }
+
+  // Tops the player's bags up to the targets of the restock profile. Deficits
+  // are computed against the current bag counts and applied as one bulk
+  // withdrawal.
+  void RestockBags(Player *player)
+  {
+    std::map<uint32, uint32> profile = GetRestockProfile(player);
+    if (profile.empty())
     {
       ChatHandler(player->GetSession())
-          .SendSysMessage("The following was deposited:");
-      for (std::pair<uint32, uint32> mapEntry : itemsAddedMap)
+          .PSendSysMessage("Your restock profile is empty.");
+      return;
+    }
+    ReagentBankOwner owner = sReagentBankMgr->GetOwner(player);
+    std::map<uint32, uint32> requests;
+    for (std::pair<uint32, uint32> profileEntry : profile)
+    {
+      uint32 itemEntry = profileEntry.first;
+      uint32 have = player->GetItemCount(itemEntry, false);
+      if (have >= profileEntry.second)
+        continue;
+      if (sReagentBankMgr->GetAmount(owner, itemEntry) == 0)
       {
-        uint32 itemEntry = mapEntry.first;
-        uint32 itemAmount = mapEntry.second;
-        ItemTemplate const *itemTemplate =
-            sObjectMgr->GetItemTemplate(itemEntry);
-        std::string itemName = itemTemplate->Name1;
+        const ItemTemplate *temp = GetCachedItemTemplate(itemEntry);
         ChatHandler(player->GetSession())
-            .SendSysMessage(std::to_string(itemAmount) + " " + itemName);
+            .PSendSysMessage("No {} left in the reagent bank.",
+                             temp ? temp->Name1 : "Unknown");
+        continue;
       }
+      requests[itemEntry] = profileEntry.second - have;
     }
-    else
+    if (requests.empty())
     {
       ChatHandler(player->GetSession())
-          .PSendSysMessage("No reagents to deposit in this category.");
+          .PSendSysMessage("Your bags are already restocked.");
+      return;
     }
-    CloseGossipMenuFor(player);
+    std::map<uint32, uint32> withdrawn;
+    ReagentBankAuditScope audit(player, AUDIT_OP_RESTOCK);
+    InventoryResult msg = sReagentBankMgr->Withdraw(player, requests, withdrawn);
+    ReportWithdrawals(player, withdrawn, msg);
   }
 
-  // Helper: Withdraw all items in a category for the player
-  void WithdrawAllInCategory(Player *player, uint32 item_subclass)
+  // Lists the restock profile with current bag counts against targets
+  void ShowRestockProfile(Player *player, Creature *creature)
   {
-    uint32 accountKey, guidKey;
-    GetStorageKeys(player, accountKey, guidKey);
-    QueryResult result = CharacterDatabase.Query(
-        "SELECT item_entry, amount FROM mod_reagent_bank_account WHERE account_id = {} AND guid = {} AND item_subclass = {}",
-        accountKey, guidKey, item_subclass);
-
-    if (!result)
+    constexpr int ICON_SIZE = 18;
+    constexpr int ICON_X = 0;
+    constexpr int ICON_Y = 0;
+    constexpr int GOSSIP_ICON_NONE = 0;
+    std::map<uint32, uint32> profile = GetRestockProfile(player);
+    player->PlayerTalkClass->ClearMenus();
+    AddGossipItemFor(player, GOSSIP_ICON_NONE, "|cff003366Restock Profile: " + std::to_string(profile.size()) + "/" + std::to_string(MAX_RESTOCK_ENTRIES) + " items|r", 0, 0);
+    if (!profile.empty())
+      AddGossipItemFor(player, GOSSIP_ICON_NONE, GetCachedItemIcon(2901, ICON_SIZE, ICON_SIZE, ICON_X, ICON_Y) + " |cff0070ddRestock Bags|r", RESTOCK_BAGS, 0);
+    for (std::pair<uint32, uint32> profileEntry : profile)
     {
-      ChatHandler(player->GetSession())
-          .PSendSysMessage("No reagents to withdraw in this category.");
-      return;
+      uint32 itemEntry = profileEntry.first;
+      uint32 have = player->GetItemCount(itemEntry, false);
+      std::string icon = GetCachedItemIcon(itemEntry, ICON_SIZE, ICON_SIZE, ICON_X, ICON_Y);
+      AddGossipItemFor(player, GOSSIP_ICON_NONE, icon + GetItemLink(itemEntry, player->GetSession()) + " |cff000000" + std::to_string(have) + "/" + std::to_string(profileEntry.second) + "|r", itemEntry, 0);
     }
+    AddGossipItemFor(player, GOSSIP_ICON_NONE, GetCachedItemIcon(6948, ICON_SIZE, ICON_SIZE, ICON_X, ICON_Y) + " |cff666666Back to Categories|r", MAIN_MENU, 0);
+    SendGossipMenuFor(player, NPC_TEXT_ID, creature->GetGUID());
+  }
 
-    bool anyWithdrawn = false;
-    do
-    {
-      uint32 itemEntry = (*result)[0].Get<uint32>();
-      uint32 amount = (*result)[1].Get<uint32>();
-      const ItemTemplate *temp = sObjectMgr->GetItemTemplate(itemEntry);
-      if (!temp)
-        continue;
+  // Splits rendered listing rows into pages and returns the index of the
+  // first row of each page. A page takes rows while they fit both maxRows
+  // (gossip option limit, capped by MaxOptionsPerPage) and pageByteBudget
+  // (ReagentBankAccount.PageByteBudget) after chromeBytes for the
+  // surrounding options.
+  static std::vector<uint32> BuildPageStarts(
+      std::vector<std::string> const &rows, uint32 chromeBytes,
+      uint32 maxRows, uint32 pageByteBudget)
+  {
+    uint32 byteBudget =
+        pageByteBudget > chromeBytes ? pageByteBudget - chromeBytes : 0;
 
-      uint32 stackSize = temp->GetMaxStackSize();
-      uint32 remaining = amount;
-      while (remaining > 0)
+    std::vector<uint32> pageStarts = {0};
+    uint32 pageRows = 0;
+    uint32 pageBytes = 0;
+    for (uint32 i = 0; i < rows.size(); ++i)
+    {
+      uint32 rowBytes = GOSSIP_OPTION_OVERHEAD + rows[i].size();
+      // A page always takes at least one row
+      if (pageRows > 0 &&
+          (pageRows == maxRows || pageBytes + rowBytes > byteBudget))
       {
-        uint32 toGive = std::min(stackSize, remaining);
-        ItemPosCountVec dest;
-        InventoryResult msg = player->CanStoreNewItem(NULL_BAG, NULL_SLOT, dest,
-                                                      itemEntry, toGive);
-        if (msg == EQUIP_ERR_OK)
-        {
-          // Remove or update the reagent in the DB
-          if (toGive == remaining)
-            CharacterDatabase.DirectExecute(
-                "DELETE FROM mod_reagent_bank_account WHERE account_id = {} AND guid = {} AND item_entry = {}",
-                accountKey, guidKey, itemEntry);
-          else
-            CharacterDatabase.DirectExecute(
-                "UPDATE mod_reagent_bank_account SET amount = {} WHERE account_id = {} AND guid = {} AND item_entry = {}",
-                remaining - toGive, accountKey, guidKey, itemEntry);
-
-          Item *item = player->StoreNewItem(dest, itemEntry, true);
-          player->SendNewItem(item, toGive, true, false);
-          ChatHandler(player->GetSession())
-              .PSendSysMessage("Withdrew {} x {}.", toGive,
-                               temp->Name1);
-          anyWithdrawn = true;
-          remaining -= toGive;
-        }
-        else
-        {
-          player->SendEquipError(msg, nullptr, nullptr, itemEntry);
-          ChatHandler(player->GetSession())
-              .PSendSysMessage("Not enough bag space to withdraw {} x {}.",
-                               toGive, temp->Name1);
-          break;
-        }
+        pageStarts.push_back(i);
+        pageRows = 0;
+        pageBytes = 0;
       }
-    } while (result->NextRow());
+      ++pageRows;
+      pageBytes += rowBytes;
+    }
+    return pageStarts;
+  }
 
-    if (!anyWithdrawn)
-      ChatHandler(player->GetSession())
-          .PSendSysMessage("No reagents withdrawn.");
+  // Last viewed (category, page) of a character, (0, 0) if there is none
+  std::pair<uint32, uint16> GetLastCategoryPage(uint32 guidLow)
+  {
+    std::lock_guard<std::mutex> guard(m_lastCategoryPageLock);
+    auto it = m_lastCategoryPage.find(guidLow);
+    if (it == m_lastCategoryPage.end())
+      return {0, 0};
+    return it->second;
   }
 
-public:
-  // Constructor: reads config for max options per page
-  mod_reagent_bank_account() : CreatureScript("mod_reagent_bank_account")
+  void SetLastCategoryPage(uint32 guidLow, uint32 category, uint16 page)
+  {
+    std::lock_guard<std::mutex> guard(m_lastCategoryPageLock);
+    m_lastCategoryPage[guidLow] = {category, page};
+  }
+
+  // Re-shows the last viewed category, or the main menu if there is none
+  void ShowLastCategory(Player *player, Creature *creature)
   {
-    g_maxOptionsPerPage = sConfigMgr->GetOption<uint32>(
-        "ReagentBankAccount.MaxOptionsPerPage", DEFAULT_MAX_OPTIONS);
-    g_accountWideReagentBank =
-        sConfigMgr->GetOption<bool>("ReagentBankAccount.AccountWide", false);
+    auto [category, page] =
+        GetLastCategoryPage(player->GetGUID().GetCounter());
+    if (IsReagentCategory(category))
+      ShowReagentItems(player, creature, category, page);
+    else
+      OnGossipHello(player, creature);
   }
 
+public:
+  // Settings are read by LoadReagentBankConfig (world script)
+  mod_reagent_bank_account() : CreatureScript("mod_reagent_bank_account") {}
+
   // Main menu for the reagent banker NPC
   bool OnGossipHello(Player *player, Creature *creature) override
   {
@@ -670,85 +591,28 @@ public:
     constexpr int MAIN_ICON_Y = 0;
     constexpr int GOSSIP_ICON_NONE = 0;
 
+    RefreshReagentBankOwner(player);
     AddGossipItemFor(player, GOSSIP_ICON_NONE, "Deposit All Reagents",
                      DEPOSIT_ALL_REAGENTS, 0);
     AddGossipItemFor(player, GOSSIP_ICON_NONE, "Withdraw All Reagents",
                      WITHDRAW_ALL_REAGENTS, 0);
-    AddGossipItemFor(player, GOSSIP_ICON_NONE,
-                     GetCachedItemIcon(2589, MAIN_ICON_SIZE, MAIN_ICON_SIZE,
-                                       MAIN_ICON_X, MAIN_ICON_Y) +
-                         "Cloth",
-                     ITEM_SUBCLASS_CLOTH, 0);
-    AddGossipItemFor(player, GOSSIP_ICON_NONE,
-                     GetCachedItemIcon(12208, MAIN_ICON_SIZE, MAIN_ICON_SIZE,
-                                       MAIN_ICON_X, MAIN_ICON_Y) +
-                         "Meat",
-                     ITEM_SUBCLASS_MEAT, 0);
-    AddGossipItemFor(player, GOSSIP_ICON_NONE,
-                     GetCachedItemIcon(2772, MAIN_ICON_SIZE, MAIN_ICON_SIZE,
-                                       MAIN_ICON_X, MAIN_ICON_Y) +
-                         "Metal & Stone",
-                     ITEM_SUBCLASS_METAL_STONE, 0);
-    AddGossipItemFor(player, GOSSIP_ICON_NONE,
-                     GetCachedItemIcon(10940, MAIN_ICON_SIZE, MAIN_ICON_SIZE,
-                                       MAIN_ICON_X, MAIN_ICON_Y) +
-                         "Enchanting",
-                     ITEM_SUBCLASS_ENCHANTING, 0);
-    AddGossipItemFor(player, GOSSIP_ICON_NONE,
-                     GetCachedItemIcon(7068, MAIN_ICON_SIZE, MAIN_ICON_SIZE,
-                                       MAIN_ICON_X, MAIN_ICON_Y) +
-                         "Elemental",
-                     ITEM_SUBCLASS_ELEMENTAL, 0);
-    AddGossipItemFor(player, GOSSIP_ICON_NONE,
-                     GetCachedItemIcon(4359, MAIN_ICON_SIZE, MAIN_ICON_SIZE,
-                                       MAIN_ICON_X, MAIN_ICON_Y) +
-                         "Parts",
-                     ITEM_SUBCLASS_PARTS, 0);
-    AddGossipItemFor(player, GOSSIP_ICON_NONE,
-                     GetCachedItemIcon(2604, MAIN_ICON_SIZE, MAIN_ICON_SIZE,
-                                       MAIN_ICON_X, MAIN_ICON_Y) +
-                         "Other Trade Goods",
-                     ITEM_SUBCLASS_TRADE_GOODS_OTHER, 0);
-    AddGossipItemFor(player, GOSSIP_ICON_NONE,
-                     GetCachedItemIcon(2453, MAIN_ICON_SIZE, MAIN_ICON_SIZE,
-                                       MAIN_ICON_X, MAIN_ICON_Y) +
-                         "Herb",
-                     ITEM_SUBCLASS_HERB, 0);
-    AddGossipItemFor(player, GOSSIP_ICON_NONE,
-                     GetCachedItemIcon(2318, MAIN_ICON_SIZE, MAIN_ICON_SIZE,
-                                       MAIN_ICON_X, MAIN_ICON_Y) +
-                         "Leather",
-                     ITEM_SUBCLASS_LEATHER, 0);
-    AddGossipItemFor(player, GOSSIP_ICON_NONE,
-                     GetCachedItemIcon(1206, MAIN_ICON_SIZE, MAIN_ICON_SIZE,
-                                       MAIN_ICON_X, MAIN_ICON_Y) +
-                         "Jewelcrafting",
-                     ITEM_SUBCLASS_JEWELCRAFTING, 0);
-    AddGossipItemFor(player, GOSSIP_ICON_NONE,
-                     GetCachedItemIcon(4358, MAIN_ICON_SIZE, MAIN_ICON_SIZE,
-                                       MAIN_ICON_X, MAIN_ICON_Y) +
-                         "Explosives",
-                     ITEM_SUBCLASS_EXPLOSIVES, 0);
-    AddGossipItemFor(player, GOSSIP_ICON_NONE,
-                     GetCachedItemIcon(4388, MAIN_ICON_SIZE, MAIN_ICON_SIZE,
-                                       MAIN_ICON_X, MAIN_ICON_Y) +
-                         "Devices",
-                     ITEM_SUBCLASS_DEVICES, 0);
-    AddGossipItemFor(player, GOSSIP_ICON_NONE,
-                     GetCachedItemIcon(23572, MAIN_ICON_SIZE, MAIN_ICON_SIZE,
-                                       MAIN_ICON_X, MAIN_ICON_Y) +
-                         "Nether Material",
-                     ITEM_SUBCLASS_MATERIAL, 0);
-    AddGossipItemFor(player, GOSSIP_ICON_NONE,
-                     GetCachedItemIcon(38682, MAIN_ICON_SIZE, MAIN_ICON_SIZE,
-                                       MAIN_ICON_X, MAIN_ICON_Y) +
-                         "Armor Vellum",
-                     ITEM_SUBCLASS_ARMOR_ENCHANTMENT, 0);
-    AddGossipItemFor(player, GOSSIP_ICON_NONE,
-                     GetCachedItemIcon(39349, MAIN_ICON_SIZE, MAIN_ICON_SIZE,
-                                       MAIN_ICON_X, MAIN_ICON_Y) +
-                         "Weapon Vellum",
-                     ITEM_SUBCLASS_WEAPON_ENCHANTMENT, 0);
+    AddGossipItemFor(player, GOSSIP_ICON_NONE, "Restock Bags", RESTOCK_BAGS,
+                     0);
+    AddGossipItemFor(player, GOSSIP_ICON_NONE, "Restock Profile",
+                     RESTOCK_PROFILE, 0);
+    if (GetReagentBankSettings()->autoDeposit)
+      AddGossipItemFor(player, GOSSIP_ICON_NONE,
+                       IsAutoDepositOptedIn(player)
+                           ? "Auto-Deposit Looted Reagents: On"
+                           : "Auto-Deposit Looted Reagents: Off",
+                       AUTO_DEPOSIT_TOGGLE, 0);
+    for (ReagentCategory const &category : REAGENT_CATEGORIES)
+      AddGossipItemFor(player, GOSSIP_ICON_NONE,
+                       GetCachedItemIcon(category.iconItem, MAIN_ICON_SIZE,
+                                         MAIN_ICON_SIZE, MAIN_ICON_X,
+                                         MAIN_ICON_Y) +
+                           category.label,
+                       category.subclass, 0);
 
     SendGossipMenuFor(player, NPC_TEXT_ID, creature->GetGUID());
     return true;
@@ -758,6 +622,20 @@ public:
   bool OnGossipSelect(Player *player, Creature *creature, uint32 item_subclass,
                       uint32 gossipPageNumber) override
   {
+    if (!AdmitRequest(player, item_subclass, gossipPageNumber))
+      return true;
+    std::optional<ReagentBankMutationGuard> mutation;
+    if (IsBankMutation(item_subclass))
+    {
+      mutation.emplace(player, sReagentBankMgr->GetOwner(player));
+      if (!mutation->IsAdmitted())
+      {
+        ChatHandler(player->GetSession())
+            .SendSysMessage("Another reagent bank operation is in progress, try again in a moment.");
+        return true;
+      }
+    }
+
     player->PlayerTalkClass->ClearMenus();
 
     if (item_subclass == DEPOSIT_ALL_REAGENTS)
@@ -779,23 +657,7 @@ public:
       if (gossipPageNumber == 0)
       {
         // Main menu: withdraw all categories
-        std::vector<uint32> subclasses = {ITEM_SUBCLASS_CLOTH,
-                                          ITEM_SUBCLASS_MEAT,
-                                          ITEM_SUBCLASS_METAL_STONE,
-                                          ITEM_SUBCLASS_ENCHANTING,
-                                          ITEM_SUBCLASS_ELEMENTAL,
-                                          ITEM_SUBCLASS_PARTS,
-                                          ITEM_SUBCLASS_TRADE_GOODS_OTHER,
-                                          ITEM_SUBCLASS_HERB,
-                                          ITEM_SUBCLASS_LEATHER,
-                                          ITEM_SUBCLASS_JEWELCRAFTING,
-                                          ITEM_SUBCLASS_EXPLOSIVES,
-                                          ITEM_SUBCLASS_DEVICES,
-                                          ITEM_SUBCLASS_MATERIAL,
-                                          ITEM_SUBCLASS_ARMOR_ENCHANTMENT,
-                                          ITEM_SUBCLASS_WEAPON_ENCHANTMENT};
-        for (uint32 subclass : subclasses)
-          WithdrawAllInCategory(player, subclass);
+        WithdrawAllReagents(player);
       }
       else
       {
@@ -805,12 +667,30 @@ public:
       CloseGossipMenuFor(player);
       return true;
     }
+    else if (item_subclass == RESTOCK_BAGS)
+    {
+      RestockBags(player);
+      CloseGossipMenuFor(player);
+      return true;
+    }
+    else if (item_subclass == RESTOCK_PROFILE)
+    {
+      ShowRestockProfile(player, creature);
+      return true;
+    }
+    else if (item_subclass == AUTO_DEPOSIT_TOGGLE)
+    {
+      if (GetReagentBankSettings()->autoDeposit)
+        SetAutoDepositOptIn(player, !IsAutoDepositOptedIn(player));
+      OnGossipHello(player, creature);
+      return true;
+    }
     else if (item_subclass == MAIN_MENU)
     {
       OnGossipHello(player, creature);
       return true;
     }
-    else if (IsCategory(item_subclass))
+    else if (IsReagentCategory(item_subclass))
     {
       // A category was selected (or changing pages inside it)
       ShowReagentItems(player, creature, item_subclass, gossipPageNumber);
@@ -820,25 +700,24 @@ public:
     {
       // Check if this is one of the submenu actions
       uint32 guidLow = player->GetGUID().GetCounter();
+      if (item_subclass == ACTION_RESTOCK_CLEAR)
+      {
+        SetRestockTarget(player, gossipPageNumber, 0);
+        ShowLastCategory(player, creature);
+        return true;
+      }
       if (item_subclass == ACTION_WITHDRAW_ONE || item_subclass == ACTION_WITHDRAW_STACK || item_subclass == ACTION_WITHDRAW_ALL)
       {
         uint32 itemEntry = gossipPageNumber; // action stores item entry in this branch
         // Retrieve last category/page (fallback to main menu if missing)
-        auto it = m_lastCategoryPage.find(guidLow);
-        uint32 category = 0;
-        uint16 pageIndex = 0;
-        if (it != m_lastCategoryPage.end())
-        {
-          category = it->second.first;
-          pageIndex = it->second.second;
-        }
+        auto [category, pageIndex] = GetLastCategoryPage(guidLow);
         if (item_subclass == ACTION_WITHDRAW_ONE)
           WithdrawOne(player, itemEntry);
         else if (item_subclass == ACTION_WITHDRAW_STACK)
           WithdrawStack(player, itemEntry);
         else if (item_subclass == ACTION_WITHDRAW_ALL)
           WithdrawAllOfItem(player, itemEntry);
-        if (IsCategory(category))
+        if (IsReagentCategory(category))
           ShowReagentItems(player, creature, category, pageIndex);
         else
           OnGossipHello(player, creature);
@@ -852,111 +731,188 @@ public:
         OnGossipHello(player, creature);
         return true;
       }
-      uint32 cat = (temp->Class == ITEM_CLASS_GEM) ? ITEM_SUBCLASS_JEWELCRAFTING : temp->SubClass;
-      m_lastCategoryPage[guidLow] = {cat, (uint16)gossipPageNumber};
+      uint32 cat = GetReagentSubclass(temp);
+      SetLastCategoryPage(guidLow, cat, (uint16)gossipPageNumber);
       ShowItemWithdrawMenu(player, creature, cat, (uint16)gossipPageNumber, itemEntry);
       return true;
     }
   }
 
+  // Rate limiting and double-click coalescing; false if the request is
+  // dropped
+  static bool AdmitRequest(Player *player, uint32 sender, uint32 action)
+  {
+    switch (sReagentBankAdmission->Admit(player, sender, action))
+    {
+    case ADMISSION_DUPLICATE:
+      return false;
+    case ADMISSION_THROTTLED:
+      ChatHandler(player->GetSession())
+          .SendSysMessage("You are doing that too fast.");
+      return false;
+    default:
+      return true;
+    }
+  }
+
+  // Selections that change the stored amounts of the player's owner
+  static bool IsBankMutation(uint32 sender)
+  {
+    return sender == DEPOSIT_ALL_REAGENTS ||
+           sender == WITHDRAW_ALL_REAGENTS || sender == RESTOCK_BAGS ||
+           sender == ACTION_WITHDRAW_ONE || sender == ACTION_WITHDRAW_STACK ||
+           sender == ACTION_WITHDRAW_ALL;
+  }
+
+  // Handles the quantity typed into the restock target popup
+  bool OnGossipSelectCode(Player *player, Creature *creature, uint32 sender,
+                          uint32 action, const char *code) override
+  {
+    if (!AdmitRequest(player, sender, action))
+      return true;
+    player->PlayerTalkClass->ClearMenus();
+    if (sender == ACTION_RESTOCK_SET && code)
+    {
+      Optional<uint32> target = Acore::StringTo<uint32>(code);
+      if (target)
+        SetRestockTarget(player, action, *target);
+      else
+        ChatHandler(player->GetSession())
+            .PSendSysMessage("Invalid restock target: {}.", code);
+    }
+    ShowLastCategory(player, creature);
+    return true;
+  }
+
   // Shows the list of stored reagents for a category, with pagination
   void ShowReagentItems(Player *player, Creature *creature,
                         uint32 item_subclass, uint16 gossipPageNumber)
   {
     WorldSession *session = player->GetSession();
-    uint32 accountKey, guidKey;
-    GetStorageKeys(player, accountKey, guidKey);
-    std::string query = "SELECT item_entry, amount FROM mod_reagent_bank_account WHERE account_id = " + std::to_string(accountKey) + " AND guid = " + std::to_string(guidKey) + " AND item_subclass = " + std::to_string(item_subclass);
-    session->GetQueryProcessor().AddCallback(CharacterDatabase.AsyncQuery(query).WithCallback([=, this](QueryResult result)
-                                                                                              {
-      // Build arrays first
-      std::map<uint32, uint32> entryToAmountMap;
-      std::vector<uint32> itemEntries;
-      uint32 totalAmount = 0;
-      if (result) {
-        do {
-          uint32 itemEntry = (*result)[0].Get<uint32>();
-          uint32 itemAmount = (*result)[1].Get<uint32>();
-          entryToAmountMap[itemEntry] = itemAmount;
-          itemEntries.push_back(itemEntry);
-          totalAmount += itemAmount;
-        } while (result->NextRow());
-      }
+    ReagentBankOwner owner = sReagentBankMgr->GetOwner(player);
+    std::vector<ReagentBankEntry> entries =
+        sReagentBankMgr->ListByCategory(owner, item_subclass);
+    std::sort(entries.begin(), entries.end(),
+              [](ReagentBankEntry const &lhs, ReagentBankEntry const &rhs)
+              { return lhs.itemEntry < rhs.itemEntry; });
+
+    ReagentCategory const *category = FindReagentCategory(item_subclass);
+    std::string categoryName = category ? category->label : "Reagents";
 
-      auto getSortKey = [this, session](uint32 entry) {
-        std::string name = GetItemName(entry, session);
-        std::transform(name.begin(), name.end(), name.begin(),
+    constexpr int ICON_SIZE = 18;
+    constexpr int ICON_X = 0;
+    constexpr int ICON_Y = 0;
+    constexpr int GOSSIP_ICON_NONE = 0;
+
+    std::string depositAll = GetCachedItemIcon(2901, ICON_SIZE, ICON_SIZE, ICON_X, ICON_Y) + " |cff1eff00Deposit All|r";
+    std::string withdrawAll = GetCachedItemIcon(2901, ICON_SIZE, ICON_SIZE, ICON_X, ICON_Y) + " |cff0070ddWithdraw All|r";
+    std::string back = GetCachedItemIcon(6948, ICON_SIZE, ICON_SIZE, ICON_X, ICON_Y) + " |cff666666Back to Categories|r";
+    auto nextPage = [&](uint32 page, uint32 pages) {
+      return GetCachedItemIcon(23705, ICON_SIZE, ICON_SIZE, ICON_X, ICON_Y) + " |cff003366Next Page|r ▶ (" + std::to_string(page) + "/" + std::to_string(pages) + ")";
+    };
+    auto previousPage = [&](uint32 page, uint32 pages) {
+      return "◀ |cff003366Previous Page|r " + GetCachedItemIcon(23705, ICON_SIZE, ICON_SIZE, ICON_X, ICON_Y) + " (" + std::to_string(page) + "/" + std::to_string(pages) + ")";
+    };
+    auto headerFor = [&](uint32 totalItems, uint32 totalAmount) {
+      return "|cff003366" + categoryName + ": " + std::to_string(totalItems) + " types, " + std::to_string(totalAmount) + " total|r";
+    };
+
+    // Page settings come from one snapshot per request, so a reload mid-way
+    // is harmless and a changed setting rebuilds the cached pages
+    ReagentBankSettingsPtr settings = GetReagentBankSettings();
+    uint32 maxRows = settings->pageRowLimit;
+    uint32 pageByteBudget = settings->pageByteBudget;
+    PageCacheKey cacheKey(owner.accountKey, owner.guidKey, item_subclass,
+                          session->GetSessionDbLocaleIndex());
+    std::shared_ptr<CategoryPages const> pages;
+    {
+      std::lock_guard<std::mutex> guard(m_pageCacheLock);
+      auto it = m_pageCache.find(cacheKey);
+      if (it != m_pageCache.end())
+        pages = it->second;
+    }
+    if (!pages || pages->maxRows != maxRows ||
+        pages->pageByteBudget != pageByteBudget ||
+        !std::equal(entries.begin(), entries.end(), pages->entries.begin(),
+                    pages->entries.end(),
+                    [](ReagentBankEntry const &lhs, ReagentBankEntry const &rhs)
+                    {
+                      return lhs.itemEntry == rhs.itemEntry &&
+                             lhs.amount == rhs.amount;
+                    }))
+    {
+      auto built = std::make_shared<CategoryPages>();
+      built->maxRows = maxRows;
+      built->pageByteBudget = pageByteBudget;
+      built->totalAmount = 0;
+      // Sorted view: entries ordered by lower-cased name, keys computed once
+      std::vector<std::pair<std::string, ReagentBankEntry>> sorted;
+      for (ReagentBankEntry const &entry : entries) {
+        std::string key = GetItemName(entry.itemEntry, session);
+        std::transform(key.begin(), key.end(), key.begin(),
                        [](unsigned char c) { return std::tolower(c); });
-        return name;
-      };
-      std::sort(itemEntries.begin(), itemEntries.end(),
-                [getSortKey](uint32 lhs, uint32 rhs) {
-                  std::string lhsKey = getSortKey(lhs);
-                  std::string rhsKey = getSortKey(rhs);
-                  if (lhsKey == rhsKey)
-                    return lhs < rhs;
-                  return lhsKey < rhsKey;
+        sorted.emplace_back(std::move(key), entry);
+        built->totalAmount += entry.amount;
+      }
+      std::sort(sorted.begin(), sorted.end(),
+                [](auto const &lhs, auto const &rhs) {
+                  if (lhs.first == rhs.first)
+                    return lhs.second.itemEntry < rhs.second.itemEntry;
+                  return lhs.first < rhs.first;
                 });
 
-      uint32 totalItems = itemEntries.size();
-      uint32 totalPages = (totalItems == 0) ? 1 : ((totalItems - 1) / g_maxOptionsPerPage) + 1;
-      uint32 clampedPageIndex = gossipPageNumber;
-      if (clampedPageIndex >= totalPages)
-        clampedPageIndex = (totalPages == 0 ? 0 : totalPages - 1);
-      uint32 startValue = clampedPageIndex * g_maxOptionsPerPage;
-      uint32 endValue = (clampedPageIndex + 1) * g_maxOptionsPerPage - 1;
-      uint32 currentPage = clampedPageIndex + 1;
-      uint32 effectivePageNumber = clampedPageIndex;
-
-      // Category name
-      std::string categoryName;
-      switch (item_subclass) {
-      case ITEM_SUBCLASS_CLOTH: categoryName = "Cloth"; break;
-      case ITEM_SUBCLASS_MEAT: categoryName = "Meat"; break;
-      case ITEM_SUBCLASS_METAL_STONE: categoryName = "Metal & Stone"; break;
-      case ITEM_SUBCLASS_ENCHANTING: categoryName = "Enchanting"; break;
-      case ITEM_SUBCLASS_ELEMENTAL: categoryName = "Elemental"; break;
-      case ITEM_SUBCLASS_PARTS: categoryName = "Parts"; break;
-      case ITEM_SUBCLASS_TRADE_GOODS_OTHER: categoryName = "Other Trade Goods"; break;
-      case ITEM_SUBCLASS_HERB: categoryName = "Herb"; break;
-      case ITEM_SUBCLASS_LEATHER: categoryName = "Leather"; break;
-      case ITEM_SUBCLASS_JEWELCRAFTING: categoryName = "Jewelcrafting"; break;
-      case ITEM_SUBCLASS_EXPLOSIVES: categoryName = "Explosives"; break;
-      case ITEM_SUBCLASS_DEVICES: categoryName = "Devices"; break;
-      case ITEM_SUBCLASS_MATERIAL: categoryName = "Nether Material"; break;
-      case ITEM_SUBCLASS_ARMOR_ENCHANTMENT: categoryName = "Armor Vellum"; break;
-      case ITEM_SUBCLASS_WEAPON_ENCHANTMENT: categoryName = "Weapon Vellum"; break;
-      default: categoryName = "Reagents"; break;
+      // Render every row once and cut the sorted view into pages. Every page
+      // reserves room for all six menu options around the rows, with the
+      // page numbers at their widest, so the boundaries never shift.
+      built->itemEntries.reserve(sorted.size());
+      built->rows.reserve(sorted.size());
+      for (auto const &[key, entry] : sorted)
+      {
+        built->itemEntries.push_back(entry.itemEntry);
+        built->rows.push_back(GetCachedItemIcon(entry.itemEntry, ICON_SIZE, ICON_SIZE, ICON_X, ICON_Y) + GetItemLink(entry.itemEntry, session) + " |cff000000x " + std::to_string(entry.amount) + "|r");
       }
+      uint32 chromeBytes = 0;
+      for (std::string const &text :
+           {headerFor(sorted.size(), built->totalAmount), depositAll,
+            withdrawAll, back, nextPage(MAX_PAGE_NUMBER, MAX_PAGE_NUMBER),
+            previousPage(MAX_PAGE_NUMBER, MAX_PAGE_NUMBER)})
+        chromeBytes += GOSSIP_OPTION_OVERHEAD + text.size();
+      built->pageStarts =
+          BuildPageStarts(built->rows, chromeBytes, maxRows, pageByteBudget);
+      built->entries = std::move(entries);
+      pages = built;
+
+      std::lock_guard<std::mutex> guard(m_pageCacheLock);
+      if (m_pageCache.size() >= PAGE_CACHE_MAX_ENTRIES)
+        m_pageCache.clear();
+      m_pageCache[cacheKey] = pages;
+    }
 
-      constexpr int ICON_SIZE = 18;
-      constexpr int ICON_X = 0;
-      constexpr int ICON_Y = 0;
-      constexpr int GOSSIP_ICON_NONE = 0;
-
-      AddGossipItemFor(player, GOSSIP_ICON_NONE, "|cff003366" + categoryName + ": " + std::to_string(totalItems) + " types, " + std::to_string(totalAmount) + " total|r", 0, 0);
-      AddGossipItemFor(player, GOSSIP_ICON_NONE, GetCachedItemIcon(2901, ICON_SIZE, ICON_SIZE, ICON_X, ICON_Y) + " |cff1eff00Deposit All|r", DEPOSIT_ALL_REAGENTS, item_subclass);
-      AddGossipItemFor(player, GOSSIP_ICON_NONE, GetCachedItemIcon(2901, ICON_SIZE, ICON_SIZE, ICON_X, ICON_Y) + " |cff0070ddWithdraw All|r", WITHDRAW_ALL_REAGENTS, item_subclass);
-
-      if (endValue < entryToAmountMap.size()) {
-        AddGossipItemFor(player, GOSSIP_ICON_NONE, GetCachedItemIcon(23705, ICON_SIZE, ICON_SIZE, ICON_X, ICON_Y) + " |cff003366Next Page|r ▶ (" + std::to_string(currentPage + 1) + "/" + std::to_string(totalPages) + ")", item_subclass, effectivePageNumber + 1);
-      }
-      if (effectivePageNumber > 0) {
-        AddGossipItemFor(player, GOSSIP_ICON_NONE, "◀ |cff003366Previous Page|r " + GetCachedItemIcon(23705, ICON_SIZE, ICON_SIZE, ICON_X, ICON_Y) + " (" + std::to_string(currentPage - 1) + "/" + std::to_string(totalPages) + ")", item_subclass, effectivePageNumber - 1);
-      }
+    uint32 totalItems = pages->rows.size();
+    std::string header = headerFor(totalItems, pages->totalAmount);
+    std::vector<uint32> const &pageStarts = pages->pageStarts;
+    uint32 totalPages = pageStarts.size();
+    uint32 effectivePageNumber = std::min<uint32>(gossipPageNumber, totalPages - 1);
+    uint32 currentPage = effectivePageNumber + 1;
+    uint32 startValue = pageStarts[effectivePageNumber];
+    uint32 endValue = currentPage < totalPages ? pageStarts[currentPage] : totalItems;
+
+    AddGossipItemFor(player, GOSSIP_ICON_NONE, header, 0, 0);
+    AddGossipItemFor(player, GOSSIP_ICON_NONE, depositAll, DEPOSIT_ALL_REAGENTS, item_subclass);
+    AddGossipItemFor(player, GOSSIP_ICON_NONE, withdrawAll, WITHDRAW_ALL_REAGENTS, item_subclass);
+
+    if (currentPage < totalPages) {
+      AddGossipItemFor(player, GOSSIP_ICON_NONE, nextPage(currentPage + 1, totalPages), item_subclass, effectivePageNumber + 1);
+    }
+    if (effectivePageNumber > 0) {
+      AddGossipItemFor(player, GOSSIP_ICON_NONE, previousPage(currentPage - 1, totalPages), item_subclass, effectivePageNumber - 1);
+    }
 
-      for (uint32 i = startValue; i <= endValue; i++) {
-        if (itemEntries.empty() || i > itemEntries.size() - 1)
-          break;
-        uint32 itemEntry = itemEntries.at(i);
-        uint32 amount = entryToAmountMap.find(itemEntry)->second;
-        std::string link = GetItemLink(itemEntry, session);
-        std::string icon = GetCachedItemIcon(itemEntry, ICON_SIZE, ICON_SIZE, ICON_X, ICON_Y);
-        AddGossipItemFor(player, GOSSIP_ICON_NONE, icon + link + " |cff000000x " + std::to_string(amount) + "|r", itemEntry, effectivePageNumber);
-      }
+    for (uint32 i = startValue; i < endValue; i++)
+      AddGossipItemFor(player, GOSSIP_ICON_NONE, pages->rows[i], pages->itemEntries[i], effectivePageNumber);
 
-      AddGossipItemFor(player, GOSSIP_ICON_NONE, GetCachedItemIcon(6948, ICON_SIZE, ICON_SIZE, ICON_X, ICON_Y) + " |cff666666Back to Categories|r", MAIN_MENU, 0);
-      SendGossipMenuFor(player, NPC_TEXT_ID, creature->GetGUID()); }));
+    AddGossipItemFor(player, GOSSIP_ICON_NONE, back, MAIN_MENU, 0);
+    SendGossipMenuFor(player, NPC_TEXT_ID, creature->GetGUID());
   }
 };
 
@@ -9,18 +9,110 @@
 #include "ScriptedCreature.h"
 #include "ScriptedGossip.h"
 #include <map>
+#include <memory>
+#include <string>
 
-#define DEFAULT_MAX_OPTIONS 7
+#define DEFAULT_MAX_OPTIONS 7 // Item rows per page, 0 = as many as fit
+#define DEFAULT_PAGE_BYTE_BUDGET 4096 // Option bytes per category page
+#define GOSSIP_OPTION_OVERHEAD 11 // Bytes of an option besides its text
+#define PAGE_CACHE_MAX_ENTRIES 1024 // Cached category listings before a reset
 #define MAX_PAGE_NUMBER 700 // Values higher than this are considered Item IDs
 #define NPC_TEXT_ID 4259    // Pre-existing NPC text
+#define MAX_RESTOCK_ENTRIES 24 // Restock profile size (fits one gossip page)
+#define DEFAULT_LEDGER_FLUSH_INTERVAL 5000 // ms between batched ledger writes
+#define DEFAULT_AUDIT_RETENTION_DAYS 30 // Days audit rows are kept
+#define DEFAULT_RATE_LIMIT_BURST 10 // Banker clicks a character can burst
+#define DEFAULT_RATE_LIMIT_PER_SECOND 4 // Banker clicks refilled per second
+#define GUILD_OWNER_FLAG 0x80000000 // account_id bit marking a guild owner key
+#define DEFAULT_TRANSFER_DIRECTORY "reagentbank" // Export/import directory
 
 enum GossipItemType : uint8 {
   DEPOSIT_ALL_REAGENTS = 16,
   MAIN_MENU = 17,
-  WITHDRAW_ALL_REAGENTS = 102
+  WITHDRAW_ALL_REAGENTS = 102,
+  RESTOCK_BAGS = 103,
+  RESTOCK_PROFILE = 104,
+  AUTO_DEPOSIT_TOGGLE = 105
 };
 
-extern uint32 g_maxOptionsPerPage;
-extern bool g_accountWideReagentBank;
+// Module settings. A snapshot is never modified: LoadReagentBankConfig
+// builds a new one and publishes it with a single atomic pointer swap, so
+// settings read from one snapshot always belong to the same load.
+struct ReagentBankSettings
+{
+  uint32 maxOptionsPerPage = DEFAULT_MAX_OPTIONS;
+  uint32 pageByteBudget = DEFAULT_PAGE_BYTE_BUDGET;
+  uint32 pageRowLimit = GOSSIP_MAX_MENU_ITEMS - 6; // Derived: rows per page
+  bool accountWide = false;
+  bool autoDeposit = false;
+  bool craftFromBank = false;
+  uint32 flushInterval = DEFAULT_LEDGER_FLUSH_INTERVAL;
+  bool guildShared = false;
+  uint32 guildDailyWithdrawLimit = 0;
+  uint32 archiveInactiveDays = 0;
+  bool repair = false;
+  uint32 rateLimitBurst = DEFAULT_RATE_LIMIT_BURST;
+  uint32 rateLimitPerSecond = DEFAULT_RATE_LIMIT_PER_SECOND;
+  bool audit = false;
+  uint32 auditRetentionDays = DEFAULT_AUDIT_RETENTION_DAYS;
+  std::string transferDirectory = DEFAULT_TRANSFER_DIRECTORY;
+};
+
+typedef std::shared_ptr<ReagentBankSettings const> ReagentBankSettingsPtr;
+
+// Current settings; lock-free, callable from any thread. Code using several
+// settings for one request keeps the returned snapshot.
+ReagentBankSettingsPtr GetReagentBankSettings();
+
+// Only trade goods and gems are stored, and unique items are skipped
+inline bool IsReagent(ItemTemplate const *itemTemplate)
+{
+  return (itemTemplate->Class == ITEM_CLASS_TRADE_GOODS ||
+          itemTemplate->Class == ITEM_CLASS_GEM) &&
+         itemTemplate->GetMaxStackSize() > 1;
+}
+
+// Category an item is stored under; gems go to ITEM_SUBCLASS_JEWELCRAFTING
+inline uint32 GetReagentSubclass(ItemTemplate const *itemTemplate)
+{
+  return itemTemplate->Class == ITEM_CLASS_GEM ? ITEM_SUBCLASS_JEWELCRAFTING
+                                               : itemTemplate->SubClass;
+}
+
+// Reads the module settings (startup and .reload config) into a new
+// snapshot and publishes it; open banker menus stay valid since pages are
+// checked per request. A storage mode change moves online characters to
+// their new bank at once.
+void LoadReagentBankConfig(bool reload);
+
+// Resolves the (account_id, guid) key a player's reagents are stored under,
+// optionally as if the player were in the given guild (0 = none). The mode
+// is read from one settings snapshot.
+void GetStorageKeys(Player *player, uint32 &accountKey, uint32 &guidKey);
+void GetStorageKeys(Player *player, uint32 guildId, uint32 &accountKey,
+                    uint32 &guidKey);
+
+inline bool IsGuildOwnerKey(uint32 accountKey)
+{
+  return (accountKey & GUILD_OWNER_FLAG) != 0;
+}
+
+// Re-resolves the storage keys of an online player (e.g. after joining or
+// leaving a guild) and moves the player's hold on the cached ledger over.
+// The guild hooks pass the guild the player is joining or leaving for (0).
+void RefreshReagentBankOwner(Player *player);
+void RefreshReagentBankOwner(Player *player, uint32 guildId);
+
+// Per-character auto-deposit opt-in, loaded on login
+bool IsAutoDepositOptedIn(Player *player);
+void SetAutoDepositOptIn(Player *player, bool optIn);
+
+// Per-character restock profile (item entry -> quantity to keep in the
+// bags), loaded on login and kept in memory while the character is online.
+// Setting a target of 0 removes the item; returns false if the profile is
+// full.
+std::map<uint32, uint32> GetRestockProfile(Player *player);
+uint32 GetRestockTarget(Player *player, uint32 itemEntry);
+bool UpdateRestockProfile(Player *player, uint32 itemEntry, uint32 target);
 
 #endif // AZEROTHCORE_REAGENTBANKACCOUNT_H
@@ -0,0 +1,121 @@
+#include "ReagentBankAccount.h"
+#include "ReagentBankMigration.h"
+#include "ReagentBankTransfer.h"
+
+using namespace Acore::ChatCommands;
+
+// Administration commands, available in game and on the console:
+//   .reagentbank migrate account|character|status|pause
+//   .reagentbank export <file> [account_id guid]
+//   .reagentbank import <file> [account offset] [guid offset] [guild offset]
+//   .reagentbank transfer (status of the running export/import)
+class mod_reagent_bank_account_command : public CommandScript
+{
+public:
+  mod_reagent_bank_account_command()
+      : CommandScript("mod_reagent_bank_account_command")
+  {
+  }
+
+  ChatCommandTable GetCommands() const override
+  {
+    static ChatCommandTable migrateCommandTable = {
+        {"account", HandleMigrateAccountCommand, SEC_ADMINISTRATOR,
+         Console::Yes},
+        {"character", HandleMigrateCharacterCommand, SEC_ADMINISTRATOR,
+         Console::Yes},
+        {"status", HandleMigrateStatusCommand, SEC_ADMINISTRATOR,
+         Console::Yes},
+        {"pause", HandleMigratePauseCommand, SEC_ADMINISTRATOR, Console::Yes}};
+    static ChatCommandTable reagentBankCommandTable = {
+        {"migrate", migrateCommandTable},
+        {"export", HandleExportCommand, SEC_ADMINISTRATOR, Console::Yes},
+        {"import", HandleImportCommand, SEC_ADMINISTRATOR, Console::Yes},
+        {"transfer", HandleTransferStatusCommand, SEC_ADMINISTRATOR,
+         Console::Yes}};
+    static ChatCommandTable commandTable = {
+        {"reagentbank", reagentBankCommandTable}};
+    return commandTable;
+  }
+
+  static bool StartMigration(ChatHandler *handler,
+                             ReagentBankMigrationDirection direction)
+  {
+    std::string message;
+    bool started = sReagentBankMigration->Start(direction, message);
+    return ReportStart(handler, started, message);
+  }
+
+  // Merges per-character rows into account-wide rows
+  static bool HandleMigrateAccountCommand(ChatHandler *handler)
+  {
+    return StartMigration(handler, MIGRATE_TO_ACCOUNT);
+  }
+
+  // Splits account-wide rows back to per-character rows
+  static bool HandleMigrateCharacterCommand(ChatHandler *handler)
+  {
+    return StartMigration(handler, MIGRATE_TO_CHARACTER);
+  }
+
+  static bool HandleMigrateStatusCommand(ChatHandler *handler)
+  {
+    handler->SendSysMessage(sReagentBankMigration->GetStatus());
+    return true;
+  }
+
+  static bool HandleMigratePauseCommand(ChatHandler *handler)
+  {
+    sReagentBankMigration->Pause();
+    handler->SendSysMessage(sReagentBankMigration->GetStatus());
+    return true;
+  }
+
+  static bool ReportStart(ChatHandler *handler, bool started,
+                          std::string const &message)
+  {
+    handler->SendSysMessage(message);
+    if (!started)
+      handler->SetSentErrorMessage(true);
+    return started;
+  }
+
+  // Streams all rows, or one owner's rows, to a file in the transfer
+  // directory
+  static bool HandleExportCommand(ChatHandler *handler, std::string path,
+                                  Optional<uint32> accountKey,
+                                  Optional<uint32> guidKey)
+  {
+    std::string message;
+    bool started = sReagentBankTransfer->StartExport(
+        path, accountKey.has_value(), accountKey.value_or(0),
+        guidKey.value_or(0), message);
+    return ReportStart(handler, started, message);
+  }
+
+  // Merges an exported file into the table, offsetting the keys
+  static bool HandleImportCommand(ChatHandler *handler, std::string path,
+                                  Optional<uint32> accountOffset,
+                                  Optional<uint32> guidOffset,
+                                  Optional<uint32> guildOffset)
+  {
+    ReagentBankKeyRemap remap;
+    remap.accountOffset = accountOffset.value_or(0);
+    remap.guidOffset = guidOffset.value_or(0);
+    remap.guildOffset = guildOffset.value_or(0);
+    std::string message;
+    bool started = sReagentBankTransfer->StartImport(path, remap, message);
+    return ReportStart(handler, started, message);
+  }
+
+  static bool HandleTransferStatusCommand(ChatHandler *handler)
+  {
+    handler->SendSysMessage(sReagentBankTransfer->GetStatus());
+    return true;
+  }
+};
+
+void AddSC_mod_reagent_bank_account_command()
+{
+  new mod_reagent_bank_account_command();
+}
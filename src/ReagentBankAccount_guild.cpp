@@ -0,0 +1,34 @@
+#include "Guild.h"
+#include "ReagentBankAccount.h"
+
+// Moves an online member's hold on the cached ledger to the bank the member
+// uses after joining or leaving a guild, so banker menus and craft-from-bank
+// see the new bank without a relog. The remove hook runs before the member
+// has left, hence the explicit guild ids.
+class mod_reagent_bank_account_guild : public GuildScript
+{
+public:
+  mod_reagent_bank_account_guild()
+      : GuildScript("mod_reagent_bank_account_guild",
+                    {GUILDHOOK_ON_ADD_MEMBER, GUILDHOOK_ON_REMOVE_MEMBER})
+  {
+  }
+
+  void OnAddMember(Guild *guild, Player *player, uint8 & /*plRank*/) override
+  {
+    if (player)
+      RefreshReagentBankOwner(player, guild->GetId());
+  }
+
+  void OnRemoveMember(Guild * /*guild*/, Player *player, bool /*isDisbanding*/,
+                      bool /*isKicked*/) override
+  {
+    if (player)
+      RefreshReagentBankOwner(player, 0);
+  }
+};
+
+void AddSC_mod_reagent_bank_account_guild()
+{
+  new mod_reagent_bank_account_guild();
+}
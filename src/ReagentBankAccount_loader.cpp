@@ -1,7 +1,17 @@
 // From SC
 void AddSC_mod_reagent_bank_account();
+void AddSC_mod_reagent_bank_account_command();
+void AddSC_mod_reagent_bank_account_guild();
+void AddSC_mod_reagent_bank_account_player();
+void AddSC_mod_reagent_bank_account_spell();
+void AddSC_mod_reagent_bank_account_world();
 
 void Addmod_reagent_bank_accountScripts()
 {
     AddSC_mod_reagent_bank_account();
+    AddSC_mod_reagent_bank_account_command();
+    AddSC_mod_reagent_bank_account_guild();
+    AddSC_mod_reagent_bank_account_player();
+    AddSC_mod_reagent_bank_account_spell();
+    AddSC_mod_reagent_bank_account_world();
 }
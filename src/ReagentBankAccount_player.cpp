@@ -0,0 +1,226 @@
+#include "ReagentBankAccount.h"
+#include "ReagentBankAdmission.h"
+#include "ReagentBankAudit.h"
+#include "ReagentBankLedger.h"
+#include "ReagentBankMgr.h"
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+
+// Characters that opted in to auto-deposit (guidLow). Read from map threads
+// by the loot hook, so guarded by a mutex.
+static std::unordered_set<uint32> s_autoDepositGuids;
+static std::mutex s_autoDepositLock;
+
+bool IsAutoDepositOptedIn(Player *player)
+{
+  std::lock_guard<std::mutex> guard(s_autoDepositLock);
+  return s_autoDepositGuids.count(player->GetGUID().GetCounter()) > 0;
+}
+
+void SetAutoDepositOptIn(Player *player, bool optIn)
+{
+  uint32 guidLow = player->GetGUID().GetCounter();
+  {
+    std::lock_guard<std::mutex> guard(s_autoDepositLock);
+    if (optIn)
+      s_autoDepositGuids.insert(guidLow);
+    else
+      s_autoDepositGuids.erase(guidLow);
+  }
+  CharacterDatabase.Execute(
+      "REPLACE INTO mod_reagent_bank_account_settings (guid, auto_deposit) VALUES ({}, {})",
+      guidLow, optIn ? 1 : 0);
+  ChatHandler(player->GetSession())
+      .SendSysMessage(optIn ? "Looted reagents will now go straight to your reagent bank."
+                             : "Looted reagents will now stay in your bags.");
+}
+
+// Restock profiles of online characters (guidLow -> item entry -> target)
+static std::unordered_map<uint32, std::map<uint32, uint32>> s_restockProfiles;
+static std::mutex s_restockLock;
+
+std::map<uint32, uint32> GetRestockProfile(Player *player)
+{
+  std::lock_guard<std::mutex> guard(s_restockLock);
+  auto it = s_restockProfiles.find(player->GetGUID().GetCounter());
+  return it == s_restockProfiles.end() ? std::map<uint32, uint32>()
+                                       : it->second;
+}
+
+uint32 GetRestockTarget(Player *player, uint32 itemEntry)
+{
+  std::lock_guard<std::mutex> guard(s_restockLock);
+  auto it = s_restockProfiles.find(player->GetGUID().GetCounter());
+  if (it == s_restockProfiles.end())
+    return 0;
+  auto target = it->second.find(itemEntry);
+  return target == it->second.end() ? 0 : target->second;
+}
+
+bool UpdateRestockProfile(Player *player, uint32 itemEntry, uint32 target)
+{
+  uint32 guidLow = player->GetGUID().GetCounter();
+  {
+    std::lock_guard<std::mutex> guard(s_restockLock);
+    std::map<uint32, uint32> &profile = s_restockProfiles[guidLow];
+    if (target == 0)
+      profile.erase(itemEntry);
+    else if (!profile.count(itemEntry) &&
+             profile.size() >= MAX_RESTOCK_ENTRIES)
+      return false;
+    else
+      profile[itemEntry] = target;
+  }
+  if (target == 0)
+    CharacterDatabase.Execute(
+        "DELETE FROM mod_reagent_bank_account_restock WHERE guid = {} AND item_entry = {}",
+        guidLow, itemEntry);
+  else
+    CharacterDatabase.Execute(
+        "REPLACE INTO mod_reagent_bank_account_restock (guid, item_entry, target) VALUES ({}, {}, {})",
+        guidLow, itemEntry, target);
+  return true;
+}
+
+// Owner key each online character holds a ledger reference on (guidLow ->
+// (account_id, guid)). Keys can change while online (guild join/leave), so
+// the reference is always released on the key it was taken with.
+static std::unordered_map<uint32, std::pair<uint32, uint32>> s_ownerKeys;
+static std::mutex s_ownerKeysLock;
+
+void RefreshReagentBankOwner(Player *player)
+{
+  RefreshReagentBankOwner(player, player->GetGuildId());
+}
+
+void RefreshReagentBankOwner(Player *player, uint32 guildId)
+{
+  uint32 accountKey, guidKey;
+  GetStorageKeys(player, guildId, accountKey, guidKey);
+  std::pair<uint32, uint32> previous;
+  {
+    std::lock_guard<std::mutex> guard(s_ownerKeysLock);
+    auto it = s_ownerKeys.find(player->GetGUID().GetCounter());
+    if (it == s_ownerKeys.end() ||
+        it->second == std::make_pair(accountKey, guidKey))
+      return;
+    previous = it->second;
+    it->second = {accountKey, guidKey};
+  }
+  sReagentBankLedger->AcquireOwner(accountKey, guidKey);
+  sReagentBankLedger->ReleaseOwner(previous.first, previous.second);
+}
+
+// Keeps the ledger of online owners in memory and moves looted reagents of
+// opted-in characters into the reagent bank. Changes are only buffered here;
+// the world script writes them in batches.
+class mod_reagent_bank_account_player : public PlayerScript
+{
+public:
+  mod_reagent_bank_account_player()
+      : PlayerScript("mod_reagent_bank_account_player",
+                     {PLAYERHOOK_ON_LOGIN, PLAYERHOOK_ON_LOGOUT,
+                      PLAYERHOOK_ON_LOOT_ITEM})
+  {
+  }
+
+  void OnPlayerLogin(Player *player) override
+  {
+    uint32 accountKey, guidKey;
+    GetStorageKeys(player, accountKey, guidKey);
+    {
+      std::lock_guard<std::mutex> guard(s_ownerKeysLock);
+      s_ownerKeys[player->GetGUID().GetCounter()] = {accountKey, guidKey};
+    }
+    sReagentBankLedger->AcquireOwner(accountKey, guidKey);
+
+    uint32 guidLow = player->GetGUID().GetCounter();
+    player->GetSession()->GetQueryProcessor().AddCallback(
+        CharacterDatabase
+            .AsyncQuery("SELECT auto_deposit FROM mod_reagent_bank_account_settings WHERE guid = " +
+                        std::to_string(guidLow))
+            .WithCallback(
+                [guidLow](QueryResult result)
+                {
+                  if (!result || !(*result)[0].Get<bool>())
+                    return;
+                  std::lock_guard<std::mutex> guard(s_autoDepositLock);
+                  s_autoDepositGuids.insert(guidLow);
+                }));
+    // Targets changed before the profile finished loading take precedence
+    player->GetSession()->GetQueryProcessor().AddCallback(
+        CharacterDatabase
+            .AsyncQuery("SELECT item_entry, target FROM mod_reagent_bank_account_restock WHERE guid = " +
+                        std::to_string(guidLow))
+            .WithCallback(
+                [guidLow](QueryResult result)
+                {
+                  if (!result)
+                    return;
+                  std::lock_guard<std::mutex> guard(s_restockLock);
+                  std::map<uint32, uint32> &profile =
+                      s_restockProfiles[guidLow];
+                  do
+                  {
+                    profile.try_emplace((*result)[0].Get<uint32>(),
+                                        (*result)[1].Get<uint32>());
+                  } while (result->NextRow());
+                }));
+  }
+
+  void OnPlayerLogout(Player *player) override
+  {
+    {
+      std::lock_guard<std::mutex> guard(s_autoDepositLock);
+      s_autoDepositGuids.erase(player->GetGUID().GetCounter());
+    }
+    {
+      std::lock_guard<std::mutex> guard(s_restockLock);
+      s_restockProfiles.erase(player->GetGUID().GetCounter());
+    }
+    sReagentBankAdmission->Forget(player);
+    std::pair<uint32, uint32> owner;
+    {
+      std::lock_guard<std::mutex> guard(s_ownerKeysLock);
+      auto it = s_ownerKeys.find(player->GetGUID().GetCounter());
+      if (it == s_ownerKeys.end())
+        return;
+      owner = it->second;
+      s_ownerKeys.erase(it);
+    }
+    sReagentBankLedger->ReleaseOwner(owner.first, owner.second);
+  }
+
+  void OnPlayerLootItem(Player *player, Item *item, uint32 count,
+                        ObjectGuid /*lootguid*/) override
+  {
+    if (!GetReagentBankSettings()->autoDeposit || !item || !IsAutoDepositOptedIn(player))
+      return;
+    ItemTemplate const *itemTemplate = item->GetTemplate();
+    if (!IsReagent(itemTemplate))
+      return;
+    uint32 itemEntry = itemTemplate->ItemId;
+
+    // The looted count may have been merged into an existing stack; only take
+    // the looted part back out of it
+    uint32 notDestroyed = count;
+    player->DestroyItemCount(item, notDestroyed, true);
+    uint32 deposited = count - notDestroyed;
+    if (deposited == 0)
+      return;
+
+    ReagentBankAuditScope audit(player, AUDIT_OP_AUTO_DEPOSIT);
+    sReagentBankMgr->Deposit(sReagentBankMgr->GetOwner(player),
+                             {{itemEntry, deposited}});
+    ChatHandler(player->GetSession())
+        .PSendSysMessage("Auto-deposited {} x {}.", deposited,
+                         itemTemplate->Name1);
+  }
+};
+
+void AddSC_mod_reagent_bank_account_player()
+{
+  new mod_reagent_bank_account_player();
+}
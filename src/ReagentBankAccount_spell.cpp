@@ -0,0 +1,63 @@
+#include "ReagentBankAccount.h"
+#include "ReagentBankAudit.h"
+#include "ReagentBankMgr.h"
+#include "Spell.h"
+#include "SpellInfo.h"
+
+// Retail-style crafting: before a tradeskill spell checks its reagents, any
+// reagent missing from the bags is moved in from the caster's reagent bank.
+// Only the in-memory ledger of the caster's owner is used and the decrement
+// is only queued, so a cast never waits on the database and "Create All"
+// runs batch into the periodic ledger write. Until the owner has finished
+// loading (right after login or a guild change) nothing is pulled and the
+// cast checks its reagents as usual. Reagents pulled for a cast that then
+// fails or is cancelled stay in the bags.
+class mod_reagent_bank_account_spell : public AllSpellScript
+{
+public:
+  mod_reagent_bank_account_spell()
+      : AllSpellScript("mod_reagent_bank_account_spell",
+                       {ALLSPELLHOOK_CAN_PREPARE})
+  {
+  }
+
+  bool CanPrepare(Spell *spell, SpellCastTargets const * /*targets*/,
+                  TriggerCastFlags /*triggerFlags*/) override
+  {
+    if (!GetReagentBankSettings()->craftFromBank || spell->m_CastItem)
+      return true;
+    Player *player = spell->GetCaster()->ToPlayer();
+    SpellInfo const *spellInfo = spell->GetSpellInfo();
+    if (!player || !spellInfo->HasAttribute(SPELL_ATTR0_IS_TRADESKILL))
+      return true;
+
+    std::map<uint32, uint32> missing;
+    for (uint32 i = 0; i < MAX_SPELL_REAGENTS; ++i)
+    {
+      if (spellInfo->Reagent[i] <= 0)
+        continue;
+      uint32 itemEntry = uint32(spellInfo->Reagent[i]);
+      uint32 needed = spellInfo->ReagentCount[i];
+      uint32 have = player->GetItemCount(itemEntry, false);
+      if (have >= needed)
+        continue;
+      ItemTemplate const *itemTemplate = sObjectMgr->GetItemTemplate(itemEntry);
+      if (itemTemplate && IsReagent(itemTemplate))
+        missing[itemEntry] = needed - have;
+    }
+    // Whatever does not fit stays in the bank; the cast then fails its own
+    // reagent check as usual
+    std::map<uint32, uint32> withdrawn;
+    if (!missing.empty())
+    {
+      ReagentBankAuditScope audit(player, AUDIT_OP_CRAFT);
+      sReagentBankMgr->Withdraw(player, missing, withdrawn, true);
+    }
+    return true;
+  }
+};
+
+void AddSC_mod_reagent_bank_account_spell()
+{
+  new mod_reagent_bank_account_spell();
+}
@@ -0,0 +1,49 @@
+#include "ReagentBankAccount.h"
+#include "ReagentBankArchive.h"
+#include "ReagentBankAudit.h"
+#include "ReagentBankLedger.h"
+#include "ReagentBankMigration.h"
+#include "ReagentBankRepair.h"
+#include "ReagentBankTransfer.h"
+
+// Drives the ledger: owner load callbacks, the batched writes (periodic or
+// early when the buffer grows large) and a final synchronous flush on
+// shutdown. Drains the audit trail on the same schedule and runs the
+// archival, consistency, migration and export/import jobs. Loads the
+// settings at startup and again on .reload config.
+class mod_reagent_bank_account_world : public WorldScript
+{
+public:
+  mod_reagent_bank_account_world()
+      : WorldScript("mod_reagent_bank_account_world",
+                    {WORLDHOOK_ON_AFTER_CONFIG_LOAD, WORLDHOOK_ON_UPDATE,
+                     WORLDHOOK_ON_SHUTDOWN})
+  {
+  }
+
+  void OnAfterConfigLoad(bool reload) override
+  {
+    LoadReagentBankConfig(reload);
+  }
+
+  void OnUpdate(uint32 diff) override
+  {
+    sReagentBankLedger->Update(diff);
+    sReagentBankAudit->Update(diff);
+    sReagentBankArchive->Update(diff);
+    sReagentBankRepair->Update(diff);
+    sReagentBankMigration->Update(diff);
+    sReagentBankTransfer->Update(diff);
+  }
+
+  void OnShutdown() override
+  {
+    sReagentBankLedger->Flush(true);
+    sReagentBankAudit->Drain(true);
+  }
+};
+
+void AddSC_mod_reagent_bank_account_world()
+{
+  new mod_reagent_bank_account_world();
+}
@@ -0,0 +1,76 @@
+#include "ReagentBankAdmission.h"
+#include "ReagentBankAccount.h"
+#include "ReagentBankMgr.h"
+#include "Timer.h"
+#include <algorithm>
+
+ReagentBankAdmission *ReagentBankAdmission::instance()
+{
+  static ReagentBankAdmission instance;
+  return &instance;
+}
+
+ReagentBankAdmissionResult
+ReagentBankAdmission::Admit(Player *player, uint32 sender, uint32 action)
+{
+  ReagentBankSettingsPtr settings = GetReagentBankSettings();
+  if (settings->rateLimitBurst == 0)
+    return ADMISSION_OK;
+  float burst = float(settings->rateLimitBurst);
+  uint32 now = getMSTime();
+  std::lock_guard<std::mutex> guard(m_lock);
+  auto result = m_buckets.try_emplace(player->GetGUID().GetCounter(),
+                                      Bucket{burst, now, 0, 0, 0});
+  Bucket &bucket = result.first->second;
+  if (!result.second && bucket.lastSender == sender &&
+      bucket.lastAction == action &&
+      getMSTimeDiff(bucket.lastRequest, now) < ADMISSION_COALESCE_WINDOW)
+    return ADMISSION_DUPLICATE;
+  bucket.tokens =
+      std::min(burst, bucket.tokens + getMSTimeDiff(bucket.lastRefill, now) *
+                                          settings->rateLimitPerSecond /
+                                          1000.0f);
+  bucket.lastRefill = now;
+  if (bucket.tokens < 1.0f)
+    return ADMISSION_THROTTLED;
+  bucket.tokens -= 1.0f;
+  bucket.lastSender = sender;
+  bucket.lastAction = action;
+  bucket.lastRequest = now;
+  return ADMISSION_OK;
+}
+
+bool ReagentBankAdmission::BeginMutation(ReagentBankOwner const &owner)
+{
+  std::lock_guard<std::mutex> guard(m_lock);
+  return m_mutatingOwners.emplace(owner.accountKey, owner.guidKey).second;
+}
+
+void ReagentBankAdmission::EndMutation(ReagentBankOwner const &owner)
+{
+  std::lock_guard<std::mutex> guard(m_lock);
+  m_mutatingOwners.erase(std::make_pair(owner.accountKey, owner.guidKey));
+}
+
+void ReagentBankAdmission::Forget(Player *player)
+{
+  std::lock_guard<std::mutex> guard(m_lock);
+  m_buckets.erase(player->GetGUID().GetCounter());
+}
+
+ReagentBankMutationGuard::ReagentBankMutationGuard(
+    Player *player, ReagentBankOwner const &owner)
+    : m_owner(owner.accountKey,
+              IsGuildOwnerKey(owner.accountKey)
+                  ? player->GetGUID().GetCounter()
+                  : owner.guidKey),
+      m_admitted(
+          sReagentBankAdmission->BeginMutation({m_owner.first, m_owner.second}))
+{
+}
+
+ReagentBankMutationGuard::~ReagentBankMutationGuard()
+{
+  if (m_admitted)
+    sReagentBankAdmission->EndMutation({m_owner.first, m_owner.second});
+}
@@ -0,0 +1,77 @@
+#ifndef AZEROTHCORE_REAGENTBANKADMISSION_H
+#define AZEROTHCORE_REAGENTBANKADMISSION_H
+#include "Define.h"
+#include <mutex>
+#include <set>
+#include <unordered_map>
+#include <utility>
+
+#define ADMISSION_COALESCE_WINDOW 300 // ms in which a repeated click is dropped
+
+class Player;
+struct ReagentBankOwner;
+
+enum ReagentBankAdmissionResult : uint8
+{
+  ADMISSION_OK = 0,
+  ADMISSION_DUPLICATE = 1, // Same request as the one just served
+  ADMISSION_THROTTLED = 2  // Out of tokens
+};
+
+// Admission control for banker requests. Every gossip selection costs one
+// token from a per-character bucket (ReagentBankAccount.RateLimit.Burst
+// tokens, refilled at RateLimit.PerSecond), a selection repeating the
+// previous one within ADMISSION_COALESCE_WINDOW is coalesced into it, and
+// only one banker mutation (deposit, withdraw, restock) can run per owner
+// at a time, which matters for account-wide owners shared by several online
+// characters. Guild banks serialize per member instead: the whole guild
+// shares one owner and withdrawals reserve atomically anyway.
+// Called from map threads.
+class ReagentBankAdmission
+{
+public:
+  static ReagentBankAdmission *instance();
+
+  ReagentBankAdmissionResult Admit(Player *player, uint32 sender,
+                                   uint32 action);
+
+  // False if a mutation for the owner is already running
+  bool BeginMutation(ReagentBankOwner const &owner);
+  void EndMutation(ReagentBankOwner const &owner);
+
+  // Drops the character's bucket (logout)
+  void Forget(Player *player);
+
+private:
+  struct Bucket
+  {
+    float tokens;
+    uint32 lastRefill;
+    uint32 lastSender;
+    uint32 lastAction;
+    uint32 lastRequest;
+  };
+
+  std::mutex m_lock;
+  std::unordered_map<uint32, Bucket> m_buckets; // guidLow -> bucket
+  std::set<std::pair<uint32, uint32>> m_mutatingOwners;
+};
+
+#define sReagentBankAdmission ReagentBankAdmission::instance()
+
+// Holds the mutation slot of the player's owner (of the player, for guild
+// banks) for the lifetime of the guard
+class ReagentBankMutationGuard
+{
+public:
+  ReagentBankMutationGuard(Player *player, ReagentBankOwner const &owner);
+  ~ReagentBankMutationGuard();
+
+  bool IsAdmitted() const { return m_admitted; }
+
+private:
+  std::pair<uint32, uint32> m_owner;
+  bool m_admitted;
+};
+
+#endif // AZEROTHCORE_REAGENTBANKADMISSION_H
@@ -0,0 +1,131 @@
+#include "ReagentBankArchive.h"
+#include "DatabaseEnv.h"
+#include "GameTime.h"
+#include "Log.h"
+#include "ReagentBankAccount.h"
+#include "ReagentBankLedger.h"
+#include <algorithm>
+
+ReagentBankArchive *ReagentBankArchive::instance()
+{
+  static ReagentBankArchive instance;
+  return &instance;
+}
+
+void ReagentBankArchive::Touch(uint32 accountKey, uint32 guidKey)
+{
+  CharacterDatabase.Execute(
+      "REPLACE INTO mod_reagent_bank_account_activity (account_id, guid, last_active) VALUES ({}, {}, {})",
+      accountKey, guidKey, uint32(GameTime::GetGameTime().count()));
+}
+
+void ReagentBankArchive::AppendRehydrate(CharacterDatabaseTransaction &trans,
+                                         uint32 accountKey, uint32 guidKey)
+{
+  trans->Append("INSERT INTO mod_reagent_bank_account (account_id, guid, item_entry, item_subclass, amount) "
+                "SELECT account_id, guid, item_entry, item_subclass, amount FROM mod_reagent_bank_account_cold WHERE account_id = {} AND guid = {} "
+                "ON DUPLICATE KEY UPDATE mod_reagent_bank_account.amount = mod_reagent_bank_account.amount + VALUES(amount)",
+                accountKey, guidKey);
+  trans->Append("DELETE FROM mod_reagent_bank_account_cold WHERE account_id = {} AND guid = {}",
+                accountKey, guidKey);
+}
+
+void ReagentBankArchive::Update(uint32 diff)
+{
+  if (GetReagentBankSettings()->archiveInactiveDays == 0)
+    return;
+  m_queryProcessor.ProcessReadyCallbacks();
+  if (m_chunkInFlight)
+    return;
+  m_timer += diff;
+  if (m_timer < (m_passRunning ? ARCHIVE_CHUNK_INTERVAL : ARCHIVE_PASS_INTERVAL))
+    return;
+  m_timer = 0;
+  if (!m_passRunning)
+  {
+    m_passRunning = true;
+    m_cursorAccount = 0;
+    m_cursorGuid = 0;
+    m_archivedOwners = 0;
+  }
+  m_chunkInFlight = true;
+  m_queryProcessor.AddCallback(
+      CharacterDatabase
+          .AsyncQuery("SELECT o.account_id, o.guid, a.last_active FROM ("
+                      "SELECT DISTINCT account_id, guid FROM mod_reagent_bank_account "
+                      "WHERE account_id > " +
+                      std::to_string(m_cursorAccount) +
+                      " OR (account_id = " + std::to_string(m_cursorAccount) +
+                      " AND guid > " + std::to_string(m_cursorGuid) +
+                      ") ORDER BY account_id, guid LIMIT " +
+                      std::to_string(ARCHIVE_CHUNK_OWNERS) +
+                      ") o LEFT JOIN mod_reagent_bank_account_activity a "
+                      "ON a.account_id = o.account_id AND a.guid = o.guid")
+          .WithCallback([this](QueryResult result)
+                        { OnChunkLoaded(result); }));
+}
+
+// Archives the inactive owners of one chunk in a single short transaction.
+// The move re-checks the activity row, so an owner that logs in meanwhile
+// stays in the hot table.
+void ReagentBankArchive::OnChunkLoaded(QueryResult result)
+{
+  m_chunkInFlight = false;
+  uint32 owners = 0;
+  if (result)
+  {
+    uint32 now = uint32(GameTime::GetGameTime().count());
+    uint32 cutoff = uint32(
+        now - std::min<uint64>(
+                  now, uint64(GetReagentBankSettings()->archiveInactiveDays) *
+                           DAY));
+    auto trans = CharacterDatabase.BeginTransaction();
+    bool changed = false;
+    do
+    {
+      Field *fields = result->Fetch();
+      uint32 accountKey = fields[0].Get<uint32>();
+      uint32 guidKey = fields[1].Get<uint32>();
+      ++owners;
+      if (std::make_pair(accountKey, guidKey) >
+          std::make_pair(m_cursorAccount, m_cursorGuid))
+      {
+        m_cursorAccount = accountKey;
+        m_cursorGuid = guidKey;
+      }
+      // Owners from before activity was tracked start their clock now
+      if (fields[2].IsNull())
+      {
+        trans->Append("INSERT IGNORE INTO mod_reagent_bank_account_activity (account_id, guid, last_active) VALUES ({}, {}, {})",
+                      accountKey, guidKey, now);
+        changed = true;
+        continue;
+      }
+      if (fields[2].Get<uint32>() >= cutoff ||
+          sReagentBankLedger->IsOwnerInUse(accountKey, guidKey))
+        continue;
+      trans->Append("INSERT INTO mod_reagent_bank_account_cold (account_id, guid, item_entry, item_subclass, amount) "
+                    "SELECT b.account_id, b.guid, b.item_entry, b.item_subclass, b.amount FROM mod_reagent_bank_account b "
+                    "JOIN mod_reagent_bank_account_activity a ON a.account_id = b.account_id AND a.guid = b.guid "
+                    "WHERE b.account_id = {} AND b.guid = {} AND a.last_active < {} "
+                    "ON DUPLICATE KEY UPDATE mod_reagent_bank_account_cold.amount = mod_reagent_bank_account_cold.amount + VALUES(amount)",
+                    accountKey, guidKey, cutoff);
+      trans->Append("DELETE b FROM mod_reagent_bank_account b "
+                    "JOIN mod_reagent_bank_account_activity a ON a.account_id = b.account_id AND a.guid = b.guid "
+                    "WHERE b.account_id = {} AND b.guid = {} AND a.last_active < {}",
+                    accountKey, guidKey, cutoff);
+      ++m_archivedOwners;
+      changed = true;
+    } while (result->NextRow());
+    if (changed)
+      CharacterDatabase.CommitTransaction(trans);
+  }
+  if (owners < ARCHIVE_CHUNK_OWNERS)
+  {
+    m_passRunning = false;
+    if (m_archivedOwners > 0)
+      LOG_INFO("module",
+               "ReagentBankAccount: archived {} inactive reagent bank owners",
+               m_archivedOwners);
+  }
+}
@@ -0,0 +1,52 @@
+#ifndef AZEROTHCORE_REAGENTBANKARCHIVE_H
+#define AZEROTHCORE_REAGENTBANKARCHIVE_H
+#include "AsyncCallbackProcessor.h"
+#include "DatabaseEnvFwd.h"
+#include "Define.h"
+
+#define ARCHIVE_CHUNK_OWNERS 100       // Owners examined per archival chunk
+#define ARCHIVE_CHUNK_INTERVAL 1000    // ms between archival chunks
+#define ARCHIVE_PASS_INTERVAL 3600000  // ms between full archival passes
+
+// Hot/cold tiering of the reagent bank. Owners that have not been active
+// for ReagentBankAccount.Archive.InactiveDays are moved from
+// mod_reagent_bank_account to the compressed mod_reagent_bank_account_cold
+// table by a background job that walks the owners in small keyset chunks,
+// one short transaction per chunk.
+//
+// Activity is tracked per owner key in mod_reagent_bank_account_activity and
+// touched whenever the ledger loads an owner (login, banker visit, API
+// access). Every read goes over both tables, so archived owners come back
+// transparently; when a load finds archived rows, the ledger moves them
+// back with the owner's next write, ordered before its changes.
+class ReagentBankArchive
+{
+public:
+  static ReagentBankArchive *instance();
+
+  // Marks the owner active (asynchronously)
+  void Touch(uint32 accountKey, uint32 guidKey);
+
+  // Appends the statements moving the owner's archived rows back into the
+  // hot table
+  void AppendRehydrate(CharacterDatabaseTransaction &trans, uint32 accountKey,
+                       uint32 guidKey);
+
+  // Drives the archival job (world thread)
+  void Update(uint32 diff);
+
+private:
+  void OnChunkLoaded(QueryResult result);
+
+  QueryCallbackProcessor m_queryProcessor;
+  bool m_chunkInFlight = false;
+  uint32 m_timer = 0;
+  uint32 m_cursorAccount = 0; // Keyset cursor: last owner examined
+  uint32 m_cursorGuid = 0;
+  bool m_passRunning = false;
+  uint32 m_archivedOwners = 0; // Owners archived in the current pass
+};
+
+#define sReagentBankArchive ReagentBankArchive::instance()
+
+#endif // AZEROTHCORE_REAGENTBANKARCHIVE_H
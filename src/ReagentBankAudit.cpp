@@ -0,0 +1,168 @@
+#include "ReagentBankAudit.h"
+#include "DatabaseEnv.h"
+#include "GameTime.h"
+#include "Log.h"
+#include "ReagentBankAccount.h"
+#include <sstream>
+
+namespace
+{
+struct AuditContext
+{
+  bool active = false;
+  uint32 character = 0;
+  uint8 operation = AUDIT_OP_OTHER;
+};
+
+thread_local AuditContext t_auditContext;
+} // namespace
+
+ReagentBankAuditScope::ReagentBankAuditScope(
+    Player *player, ReagentBankAuditOperation operation)
+    : m_active(!t_auditContext.active)
+{
+  if (!m_active)
+    return;
+  t_auditContext.active = true;
+  t_auditContext.character = player ? player->GetGUID().GetCounter() : 0;
+  t_auditContext.operation = operation;
+}
+
+ReagentBankAuditScope::~ReagentBankAuditScope()
+{
+  if (m_active)
+    t_auditContext = AuditContext();
+}
+
+ReagentBankAudit *ReagentBankAudit::instance()
+{
+  static ReagentBankAudit instance;
+  return &instance;
+}
+
+ReagentBankAudit::Ring *ReagentBankAudit::GetThreadRing()
+{
+  thread_local Ring *ring = nullptr;
+  if (!ring)
+  {
+    std::lock_guard<std::mutex> guard(m_ringsLock);
+    m_rings.push_back(std::make_unique<Ring>());
+    ring = m_rings.back().get();
+  }
+  return ring;
+}
+
+void ReagentBankAudit::Record(uint32 accountKey, uint32 guidKey,
+                              uint32 itemEntry, int32 delta)
+{
+  if (!GetReagentBankSettings()->audit)
+    return;
+  Ring *ring = GetThreadRing();
+  uint32 head = ring->head.load(std::memory_order_relaxed);
+  if (head - ring->tail.load(std::memory_order_acquire) == AUDIT_RING_SIZE)
+  {
+    m_dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  ring->records[head % AUDIT_RING_SIZE] = {
+      uint32(GameTime::GetGameTime().count()), accountKey, guidKey,
+      t_auditContext.character, itemEntry, delta, t_auditContext.operation};
+  ring->head.store(head + 1, std::memory_order_release);
+}
+
+void ReagentBankAudit::Drain(bool sync)
+{
+  std::vector<ReagentBankAuditRecord> records;
+  {
+    std::lock_guard<std::mutex> guard(m_ringsLock);
+    for (auto const &ring : m_rings)
+    {
+      uint32 tail = ring->tail.load(std::memory_order_relaxed);
+      uint32 head = ring->head.load(std::memory_order_acquire);
+      for (; tail != head; ++tail)
+        records.push_back(ring->records[tail % AUDIT_RING_SIZE]);
+      ring->tail.store(tail, std::memory_order_release);
+    }
+  }
+  if (uint32 dropped = m_dropped.exchange(0))
+    LOG_WARN("module",
+             "ReagentBankAccount: audit buffer full, {} records dropped",
+             dropped);
+  if (records.empty())
+    return;
+
+  auto trans = CharacterDatabase.BeginTransaction();
+  std::ostringstream ss;
+  uint32 rows = 0;
+  for (ReagentBankAuditRecord const &record : records)
+  {
+    ss << (rows == 0 ? "INSERT INTO mod_reagent_bank_account_audit (time, account_id, guid, character_guid, item_entry, delta, operation) VALUES "
+                     : ", ")
+       << "(" << record.time << ", " << record.accountKey << ", "
+       << record.guidKey << ", " << record.character << ", "
+       << record.itemEntry << ", " << record.delta << ", "
+       << uint32(record.operation) << ")";
+    if (++rows == AUDIT_ROWS_PER_STATEMENT)
+    {
+      trans->Append(ss.str());
+      ss.str("");
+      rows = 0;
+    }
+  }
+  if (rows > 0)
+    trans->Append(ss.str());
+  if (sync)
+    CharacterDatabase.DirectCommitTransaction(trans);
+  else
+    CharacterDatabase.CommitTransaction(trans);
+}
+
+void ReagentBankAudit::Update(uint32 diff)
+{
+  m_queryProcessor.ProcessReadyCallbacks();
+  m_drainTimer += diff;
+  if (m_drainTimer >= GetReagentBankSettings()->flushInterval)
+  {
+    m_drainTimer = 0;
+    Drain();
+  }
+  ReagentBankSettingsPtr settings = GetReagentBankSettings();
+  if (!settings->audit || settings->auditRetentionDays == 0 ||
+      m_retentionInFlight)
+    return;
+  m_retentionTimer += diff;
+  if (m_retentionTimer < (m_retentionCutoff ? AUDIT_RETENTION_BATCH_INTERVAL
+                                            : AUDIT_RETENTION_INTERVAL))
+    return;
+  m_retentionTimer = 0;
+  if (!m_retentionCutoff)
+  {
+    int64 cutoff = int64(GameTime::GetGameTime().count()) -
+                   int64(settings->auditRetentionDays) * DAY;
+    if (cutoff <= 0)
+      return;
+    m_retentionCutoff = uint32(cutoff);
+  }
+  // Counts the next batch first, so the sweep knows when it is done
+  uint32 cutoff = m_retentionCutoff;
+  m_retentionInFlight = true;
+  m_queryProcessor.AddCallback(
+      CharacterDatabase
+          .AsyncQuery("SELECT COUNT(*) FROM (SELECT 1 FROM mod_reagent_bank_account_audit WHERE time < " +
+                      std::to_string(cutoff) + " LIMIT " +
+                      std::to_string(AUDIT_RETENTION_BATCH) + ") t")
+          .WithCallback([this, cutoff](QueryResult result)
+                        { OnRetentionProbe(cutoff, result); }));
+}
+
+void ReagentBankAudit::OnRetentionProbe(uint32 cutoff, QueryResult result)
+{
+  m_retentionInFlight = false;
+  uint64 rows = result ? (*result)[0].Get<uint64>() : 0;
+  if (rows > 0)
+    CharacterDatabase.Execute(
+        "DELETE FROM mod_reagent_bank_account_audit WHERE time < {} ORDER BY time LIMIT {}",
+        cutoff, rows);
+  if (rows < AUDIT_RETENTION_BATCH)
+    m_retentionCutoff = 0;
+}
@@ -0,0 +1,100 @@
+#ifndef AZEROTHCORE_REAGENTBANKAUDIT_H
+#define AZEROTHCORE_REAGENTBANKAUDIT_H
+#include "AsyncCallbackProcessor.h"
+#include "DatabaseEnvFwd.h"
+#include "Define.h"
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#define AUDIT_RING_SIZE 8192          // Records buffered per producing thread
+#define AUDIT_ROWS_PER_STATEMENT 512  // Rows per multi-row audit insert
+#define AUDIT_RETENTION_INTERVAL 3600000 // ms between retention sweeps
+#define AUDIT_RETENTION_BATCH 5000    // Rows deleted per retention statement
+#define AUDIT_RETENTION_BATCH_INTERVAL 1000 // ms between retention batches
+
+class Player;
+
+// What caused a ledger change; stored in the operation column
+enum ReagentBankAuditOperation : uint8
+{
+  AUDIT_OP_OTHER = 0, // API callers that did not name an operation
+  AUDIT_OP_DEPOSIT = 1,
+  AUDIT_OP_WITHDRAW = 2,
+  AUDIT_OP_AUTO_DEPOSIT = 3,
+  AUDIT_OP_CRAFT = 4,
+  AUDIT_OP_RESTOCK = 5
+};
+
+struct ReagentBankAuditRecord
+{
+  uint32 time;
+  uint32 accountKey;
+  uint32 guidKey;
+  uint32 character; // guidLow of the acting character, 0 if none
+  uint32 itemEntry;
+  int32 delta;
+  uint8 operation;
+};
+
+// Names the character and operation behind the ledger changes made on this
+// thread while the scope is alive. Scopes nest; the outermost one wins, so
+// e.g. a restock keeps its operation through the withdraw it calls.
+class ReagentBankAuditScope
+{
+public:
+  ReagentBankAuditScope(Player *player, ReagentBankAuditOperation operation);
+  ~ReagentBankAuditScope();
+
+private:
+  bool m_active;
+};
+
+// Audit trail of every ledger change. Each producing thread appends to its
+// own single-producer ring buffer without taking a lock; the world thread
+// drains all rings into mod_reagent_bank_account_audit with large batched
+// inserts and periodically deletes rows past the retention period, in
+// bounded batches spread over later ticks. If a ring fills up between
+// drains the newest records are dropped and counted.
+class ReagentBankAudit
+{
+public:
+  static ReagentBankAudit *instance();
+
+  // Records a change made by the current thread (lock-free)
+  void Record(uint32 accountKey, uint32 guidKey, uint32 itemEntry,
+              int32 delta);
+
+  // Writes everything buffered so far (synchronously on shutdown)
+  void Drain(bool sync = false);
+
+  // Periodic drain and retention sweep (world thread). Records buffered
+  // before the trail was disabled are still written.
+  void Update(uint32 diff);
+
+private:
+  struct Ring
+  {
+    std::array<ReagentBankAuditRecord, AUDIT_RING_SIZE> records;
+    std::atomic<uint32> head{0}; // Next slot to write, producer only
+    std::atomic<uint32> tail{0}; // Next slot to read, consumer only
+  };
+
+  Ring *GetThreadRing();
+  void OnRetentionProbe(uint32 cutoff, QueryResult result);
+
+  std::mutex m_ringsLock; // Taken once per thread and by Drain
+  std::vector<std::unique_ptr<Ring>> m_rings;
+  std::atomic<uint32> m_dropped{0};
+  uint32 m_drainTimer = 0;
+  uint32 m_retentionTimer = 0;
+  QueryCallbackProcessor m_queryProcessor;
+  bool m_retentionInFlight = false;
+  uint32 m_retentionCutoff = 0; // Cutoff of the running sweep, 0 if none
+};
+
+#define sReagentBankAudit ReagentBankAudit::instance()
+
+#endif // AZEROTHCORE_REAGENTBANKAUDIT_H
@@ -0,0 +1,76 @@
+#ifndef AZEROTHCORE_REAGENTBANKCATEGORIES_H
+#define AZEROTHCORE_REAGENTBANKCATEGORIES_H
+#include "Define.h"
+#include "ItemTemplate.h"
+#include <array>
+
+// A category of the banker menu
+struct ReagentCategory
+{
+  uint32 subclass;   // ITEM_SUBCLASS_* (gems are stored under jewelcrafting)
+  char const *label; // Menu and listing title
+  uint32 iconItem;   // Item whose icon is shown next to the label
+};
+
+// Every category, in display order. All menus, listings and bulk operations
+// are generated from this table, so adding a category is a one-line change.
+inline constexpr std::array<ReagentCategory, 15> REAGENT_CATEGORIES = {{
+    {ITEM_SUBCLASS_CLOTH, "Cloth", 2589},
+    {ITEM_SUBCLASS_MEAT, "Meat", 12208},
+    {ITEM_SUBCLASS_METAL_STONE, "Metal & Stone", 2772},
+    {ITEM_SUBCLASS_ENCHANTING, "Enchanting", 10940},
+    {ITEM_SUBCLASS_ELEMENTAL, "Elemental", 7068},
+    {ITEM_SUBCLASS_PARTS, "Parts", 4359},
+    {ITEM_SUBCLASS_TRADE_GOODS_OTHER, "Other Trade Goods", 2604},
+    {ITEM_SUBCLASS_HERB, "Herb", 2453},
+    {ITEM_SUBCLASS_LEATHER, "Leather", 2318},
+    {ITEM_SUBCLASS_JEWELCRAFTING, "Jewelcrafting", 1206},
+    {ITEM_SUBCLASS_EXPLOSIVES, "Explosives", 4358},
+    {ITEM_SUBCLASS_DEVICES, "Devices", 4388},
+    {ITEM_SUBCLASS_MATERIAL, "Nether Material", 23572},
+    {ITEM_SUBCLASS_ARMOR_ENCHANTMENT, "Armor Vellum", 38682},
+    {ITEM_SUBCLASS_WEAPON_ENCHANTMENT, "Weapon Vellum", 39349},
+}};
+
+namespace ReagentCategories
+{
+constexpr bool UsesTradeGoodsSubclasses()
+{
+  for (ReagentCategory const &category : REAGENT_CATEGORIES)
+    if (category.subclass >= MAX_ITEM_SUBCLASS_TRADE_GOODS)
+      return false;
+  return true;
+}
+static_assert(UsesTradeGoodsSubclasses(),
+              "REAGENT_CATEGORIES must use trade goods subclasses");
+
+// subclass -> index into REAGENT_CATEGORIES, -1 if not a category
+constexpr std::array<int8, MAX_ITEM_SUBCLASS_TRADE_GOODS> BuildIndex()
+{
+  std::array<int8, MAX_ITEM_SUBCLASS_TRADE_GOODS> index{};
+  for (int8 &slot : index)
+    slot = -1;
+  for (std::size_t i = 0; i < REAGENT_CATEGORIES.size(); ++i)
+    index[REAGENT_CATEGORIES[i].subclass] = int8(i);
+  return index;
+}
+
+inline constexpr std::array<int8, MAX_ITEM_SUBCLASS_TRADE_GOODS> INDEX =
+    BuildIndex();
+} // namespace ReagentCategories
+
+// O(1) lookup; nullptr if the value is not a category
+constexpr ReagentCategory const *FindReagentCategory(uint32 subclass)
+{
+  return subclass < ReagentCategories::INDEX.size() &&
+                 ReagentCategories::INDEX[subclass] >= 0
+             ? &REAGENT_CATEGORIES[ReagentCategories::INDEX[subclass]]
+             : nullptr;
+}
+
+constexpr bool IsReagentCategory(uint32 subclass)
+{
+  return FindReagentCategory(subclass) != nullptr;
+}
+
+#endif // AZEROTHCORE_REAGENTBANKCATEGORIES_H
@@ -0,0 +1,634 @@
+#include "ReagentBankLedger.h"
+#include "DatabaseEnv.h"
+#include "GameTime.h"
+#include "Log.h"
+#include "ReagentBankAccount.h"
+#include "ReagentBankArchive.h"
+#include "ReagentBankAudit.h"
+#include "ReagentBankRepair.h"
+#include "Timer.h"
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <set>
+#include <sstream>
+#include <thread>
+
+ReagentBankLedger *ReagentBankLedger::instance()
+{
+  static ReagentBankLedger instance;
+  return &instance;
+}
+
+ReagentBankLedger::Shard &ReagentBankLedger::GetShard(uint32 accountKey,
+                                                      uint32 guidKey)
+{
+  return m_shards[(accountKey * 31 + guidKey) % LEDGER_SHARD_COUNT];
+}
+
+ReagentBankLedger::Shard const &
+ReagentBankLedger::GetShard(uint32 accountKey, uint32 guidKey) const
+{
+  return m_shards[(accountKey * 31 + guidKey) % LEDGER_SHARD_COUNT];
+}
+
+void ReagentBankLedger::QueueDelta(uint32 accountKey, uint32 guidKey,
+                                   uint32 itemEntry, uint32 itemSubclass,
+                                   int32 delta)
+{
+  if (delta == 0)
+    return;
+  {
+    Shard &shard = GetShard(accountKey, guidKey);
+    std::lock_guard<std::mutex> guard(shard.lock);
+    LedgerKey key(accountKey, guidKey, itemEntry);
+    ApplyToCacheLocked(shard, key, delta);
+    QueueDeltaLocked(shard, key, itemSubclass, delta);
+  }
+  Notify(accountKey, guidKey, itemEntry, delta);
+}
+
+void ReagentBankLedger::QueueDeltaLocked(Shard &shard, LedgerKey const &key,
+                                         uint32 itemSubclass, int32 delta)
+{
+  auto result = shard.pending.try_emplace(key, PendingDelta{itemSubclass, 0});
+  result.first->second.delta += delta;
+  if (result.first->second.delta == 0)
+    shard.pending.erase(result.first);
+}
+
+void ReagentBankLedger::ApplyToCacheLocked(Shard &shard, LedgerKey const &key,
+                                           int32 delta)
+{
+  auto owner =
+      shard.owners.find(OwnerKey(std::get<0>(key), std::get<1>(key)));
+  if (owner == shard.owners.end() || !owner->second.loaded)
+    return;
+  auto &amounts = owner->second.amounts;
+  int64 amount = int64(amounts[std::get<2>(key)]) + delta;
+  if (amount <= 0)
+    amounts.erase(std::get<2>(key));
+  else
+    amounts[std::get<2>(key)] = uint32(amount);
+}
+
+// Pending changes of an owner whose rows are still being read stay in the
+// buffer, so the snapshot never already contains a change it is merged with
+bool ReagentBankLedger::IsLoadingLocked(Shard const &shard,
+                                        OwnerKey const &owner)
+{
+  auto it = shard.owners.find(owner);
+  return it != shard.owners.end() && !it->second.loaded;
+}
+
+bool ReagentBankLedger::IsWritingLocked(Shard const &shard,
+                                        OwnerKey const &owner)
+{
+  return shard.writing.count(owner) > 0;
+}
+
+void ReagentBankLedger::Flush(bool sync)
+{
+  if (sync)
+  {
+    // Shutdown: let the writes in flight land first, then write everything,
+    // including owners whose load will never complete
+    uint32 start = getMSTime();
+    while (HasWritesInFlight())
+    {
+      if (getMSTimeDiff(start, getMSTime()) > LEDGER_SHUTDOWN_WAIT)
+      {
+        LOG_ERROR("module", "ReagentBankAccount: gave up waiting for "
+                            "reagent bank writes in flight");
+        break;
+      }
+      ProcessCommits();
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+  PendingMap pending;
+  std::set<OwnerKey> rehydrate;
+  for (Shard &shard : m_shards)
+  {
+    std::lock_guard<std::mutex> guard(shard.lock);
+    std::set<OwnerKey> owners;
+    for (auto it = shard.pending.begin(); it != shard.pending.end();)
+    {
+      OwnerKey owner(std::get<0>(it->first), std::get<1>(it->first));
+      if (!sync && (IsLoadingLocked(shard, owner) ||
+                    IsWritingLocked(shard, owner)))
+      {
+        ++it;
+        continue;
+      }
+      owners.insert(owner);
+      pending.insert(*it);
+      it = shard.pending.erase(it);
+    }
+    for (auto it = shard.rehydrate.begin(); it != shard.rehydrate.end();)
+    {
+      if (!sync && IsWritingLocked(shard, *it))
+      {
+        ++it;
+        continue;
+      }
+      owners.insert(*it);
+      rehydrate.insert(*it);
+      it = shard.rehydrate.erase(it);
+    }
+    for (OwnerKey const &owner : owners)
+      ++shard.writing[owner];
+  }
+  Write(pending, rehydrate, sync);
+}
+
+void ReagentBankLedger::FlushOwner(uint32 accountKey, uint32 guidKey)
+{
+  OwnerKey owner(accountKey, guidKey);
+  PendingMap pending;
+  std::set<OwnerKey> rehydrate;
+  Shard &shard = GetShard(accountKey, guidKey);
+  while (true)
+  {
+    {
+      std::lock_guard<std::mutex> guard(shard.lock);
+      if (IsLoadingLocked(shard, owner))
+        return;
+      if (!IsWritingLocked(shard, owner))
+      {
+        auto first = shard.pending.lower_bound(LedgerKey(accountKey, guidKey, 0));
+        auto last = shard.pending.upper_bound(LedgerKey(
+            accountKey, guidKey, std::numeric_limits<uint32>::max()));
+        if (shard.rehydrate.erase(owner))
+          rehydrate.insert(owner);
+        else if (first == last)
+          return;
+        pending.insert(first, last);
+        shard.pending.erase(first, last);
+        ++shard.writing[owner];
+        break;
+      }
+    }
+    ProcessCommits();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  Write(pending, rehydrate, true);
+}
+
+std::size_t ReagentBankLedger::GetPendingCount() const
+{
+  std::size_t count = 0;
+  for (Shard const &shard : m_shards)
+  {
+    std::lock_guard<std::mutex> guard(shard.lock);
+    count += shard.pending.size();
+  }
+  return count;
+}
+
+bool ReagentBankLedger::HasWritesInFlight() const
+{
+  return std::any_of(m_shards.begin(), m_shards.end(),
+                     [](Shard const &shard)
+                     {
+                       std::lock_guard<std::mutex> guard(shard.lock);
+                       return !shard.writing.empty();
+                     });
+}
+
+bool ReagentBankLedger::IsOwnerInUse(uint32 accountKey, uint32 guidKey) const
+{
+  Shard const &shard = GetShard(accountKey, guidKey);
+  std::lock_guard<std::mutex> guard(shard.lock);
+  OwnerKey owner(accountKey, guidKey);
+  if (shard.owners.count(owner) || IsWritingLocked(shard, owner) ||
+      shard.rehydrate.count(owner))
+    return true;
+  auto it = shard.pending.lower_bound(LedgerKey(accountKey, guidKey, 0));
+  return it != shard.pending.end() && std::get<0>(it->first) == accountKey &&
+         std::get<1>(it->first) == guidKey;
+}
+
+// Reads the hot and the archived rows in one statement, so a load racing
+// an archival or rehydration sees every row exactly once. The third column
+// tells whether any of the item's rows is archived.
+std::string ReagentBankLedger::BuildLoadQuery(OwnerKey const &owner)
+{
+  std::string where = " WHERE account_id = " + std::to_string(owner.first) +
+                      " AND guid = " + std::to_string(owner.second);
+  return "SELECT item_entry, SUM(amount), MAX(cold) FROM (SELECT item_entry, amount, 0 AS cold FROM mod_reagent_bank_account" +
+         where +
+         " UNION ALL SELECT item_entry, amount, 1 FROM mod_reagent_bank_account_cold" +
+         where + ") t GROUP BY item_entry";
+}
+
+void ReagentBankLedger::IssueLoad(OwnerKey const &owner, uint32 loadId)
+{
+  std::lock_guard<std::mutex> guard(m_queryLock);
+  m_queryProcessor.AddCallback(
+      CharacterDatabase.AsyncQuery(BuildLoadQuery(owner))
+          .WithCallback([this, owner, loadId](QueryResult result)
+                        { OnOwnerLoaded(owner, loadId, result); }));
+}
+
+// A load of an owner with a write in flight is deferred until that write has
+// committed (see EndWrite), so the snapshot always contains it
+void ReagentBankLedger::AcquireOwner(uint32 accountKey, uint32 guidKey,
+                                     std::function<void()> onLoaded)
+{
+  OwnerKey owner(accountKey, guidKey);
+  uint32 loadId;
+  bool deferred;
+  {
+    Shard &shard = GetShard(accountKey, guidKey);
+    std::unique_lock<std::mutex> guard(shard.lock);
+    OwnerLedger &ledger = shard.owners[owner];
+    if (onLoaded && !ledger.loaded)
+      ledger.onLoaded.push_back(std::move(onLoaded));
+    if (++ledger.refCount > 1)
+    {
+      guard.unlock();
+      if (onLoaded)
+        onLoaded();
+      return;
+    }
+    loadId = ledger.loadId = ++m_nextLoadId;
+    deferred = ledger.loadDeferred = IsWritingLocked(shard, owner);
+  }
+  sReagentBankArchive->Touch(accountKey, guidKey);
+  if (!deferred)
+    IssueLoad(owner, loadId);
+}
+
+void ReagentBankLedger::AcquireOwnerNow(uint32 accountKey, uint32 guidKey)
+{
+  OwnerKey owner(accountKey, guidKey);
+  uint32 loadId;
+  {
+    Shard &shard = GetShard(accountKey, guidKey);
+    std::lock_guard<std::mutex> guard(shard.lock);
+    OwnerLedger &ledger = shard.owners[owner];
+    ++ledger.refCount;
+    if (ledger.loaded)
+      return;
+    // Supersedes an asynchronous load that is still in flight or deferred
+    loadId = ledger.loadId = ++m_nextLoadId;
+    ledger.loadDeferred = false;
+  }
+  sReagentBankArchive->Touch(accountKey, guidKey);
+  // A loading owner gets no new writes, so this only waits for the one
+  // already in flight
+  WaitForWrites(owner);
+  OnOwnerLoaded(owner, loadId, CharacterDatabase.Query(BuildLoadQuery(owner)));
+}
+
+void ReagentBankLedger::ReloadOwner(uint32 accountKey, uint32 guidKey)
+{
+  OwnerKey owner(accountKey, guidKey);
+  uint32 loadId;
+  {
+    Shard &shard = GetShard(accountKey, guidKey);
+    std::lock_guard<std::mutex> guard(shard.lock);
+    auto it = shard.owners.find(owner);
+    if (it == shard.owners.end())
+      return;
+    // Changes not written yet are held back while loading and merged into
+    // the new snapshot
+    it->second.loaded = false;
+    it->second.amounts.clear();
+    loadId = it->second.loadId = ++m_nextLoadId;
+    it->second.loadDeferred = IsWritingLocked(shard, owner);
+    if (it->second.loadDeferred)
+      return;
+  }
+  IssueLoad(owner, loadId);
+}
+
+void ReagentBankLedger::ReleaseOwner(uint32 accountKey, uint32 guidKey)
+{
+  Shard &shard = GetShard(accountKey, guidKey);
+  std::lock_guard<std::mutex> guard(shard.lock);
+  auto it = shard.owners.find(OwnerKey(accountKey, guidKey));
+  if (it == shard.owners.end() || --it->second.refCount > 0)
+    return;
+  shard.owners.erase(it);
+}
+
+// Builds the in-memory copy from the snapshot plus the changes queued while
+// it was being read. Archived rows are moved back by the owner's next write,
+// ahead of its changes, so only owners that have any pay for it. Callbacks
+// waiting for the load run after the shard lock is dropped.
+void ReagentBankLedger::OnOwnerLoaded(OwnerKey const &owner, uint32 loadId,
+                                      QueryResult result)
+{
+  std::vector<std::function<void()>> onLoaded;
+  {
+    Shard &shard = GetShard(owner.first, owner.second);
+    std::lock_guard<std::mutex> guard(shard.lock);
+    if (!ApplyLoadLocked(shard, owner, loadId, result))
+      return;
+    onLoaded.swap(shard.owners[owner].onLoaded);
+  }
+  for (std::function<void()> const &callback : onLoaded)
+    callback();
+}
+
+bool ReagentBankLedger::ApplyLoadLocked(Shard &shard, OwnerKey const &owner,
+                                        uint32 loadId, QueryResult result)
+{
+  auto it = shard.owners.find(owner);
+  if (it == shard.owners.end() || it->second.loadId != loadId)
+    return false;
+  auto &amounts = it->second.amounts;
+  if (result)
+  {
+    do
+    {
+      amounts[(*result)[0].Get<uint32>()] = (*result)[1].Get<uint32>();
+      if ((*result)[2].Get<uint32>())
+        shard.rehydrate.insert(owner);
+    } while (result->NextRow());
+  }
+  it->second.loaded = true;
+  auto first =
+      shard.pending.lower_bound(LedgerKey(owner.first, owner.second, 0));
+  auto last = shard.pending.upper_bound(LedgerKey(
+      owner.first, owner.second, std::numeric_limits<uint32>::max()));
+  for (; first != last; ++first)
+    ApplyToCacheLocked(shard, first->first, first->second.delta);
+  return true;
+}
+
+bool ReagentBankLedger::GetCachedAmount(uint32 accountKey, uint32 guidKey,
+                                        uint32 itemEntry,
+                                        uint32 &amount) const
+{
+  Shard const &shard = GetShard(accountKey, guidKey);
+  std::lock_guard<std::mutex> guard(shard.lock);
+  auto owner = shard.owners.find(OwnerKey(accountKey, guidKey));
+  if (owner == shard.owners.end() || !owner->second.loaded)
+    return false;
+  auto it = owner->second.amounts.find(itemEntry);
+  amount = it == owner->second.amounts.end() ? 0 : it->second;
+  return true;
+}
+
+bool ReagentBankLedger::GetCachedAmounts(
+    uint32 accountKey, uint32 guidKey,
+    std::unordered_map<uint32, uint32> &amounts) const
+{
+  Shard const &shard = GetShard(accountKey, guidKey);
+  std::lock_guard<std::mutex> guard(shard.lock);
+  auto owner = shard.owners.find(OwnerKey(accountKey, guidKey));
+  if (owner == shard.owners.end() || !owner->second.loaded)
+    return false;
+  amounts = owner->second.amounts;
+  return true;
+}
+
+uint32 ReagentBankLedger::TakeCached(uint32 accountKey, uint32 guidKey,
+                                     uint32 itemEntry, uint32 itemSubclass,
+                                     uint32 wanted)
+{
+  uint32 taken;
+  {
+    Shard &shard = GetShard(accountKey, guidKey);
+    std::lock_guard<std::mutex> guard(shard.lock);
+    auto owner = shard.owners.find(OwnerKey(accountKey, guidKey));
+    if (owner == shard.owners.end() || !owner->second.loaded)
+      return 0;
+    auto it = owner->second.amounts.find(itemEntry);
+    if (it == owner->second.amounts.end())
+      return 0;
+    taken = std::min(wanted, it->second);
+    if (taken == 0)
+      return 0;
+    LedgerKey key(accountKey, guidKey, itemEntry);
+    ApplyToCacheLocked(shard, key, -int32(taken));
+    QueueDeltaLocked(shard, key, itemSubclass, -int32(taken));
+  }
+  Notify(accountKey, guidKey, itemEntry, -int32(taken));
+  return taken;
+}
+
+uint32 ReagentBankLedger::AddListener(ChangeListener listener)
+{
+  std::lock_guard<std::mutex> guard(m_listenerLock);
+  auto listeners = std::make_shared<ListenerMap>(*m_listeners);
+  (*listeners)[++m_nextListenerId] = std::move(listener);
+  m_listeners = std::move(listeners);
+  return m_nextListenerId;
+}
+
+void ReagentBankLedger::RemoveListener(uint32 id)
+{
+  std::lock_guard<std::mutex> guard(m_listenerLock);
+  auto listeners = std::make_shared<ListenerMap>(*m_listeners);
+  listeners->erase(id);
+  m_listeners = std::move(listeners);
+}
+
+void ReagentBankLedger::Notify(uint32 accountKey, uint32 guidKey,
+                               uint32 itemEntry, int32 delta) const
+{
+  sReagentBankAudit->Record(accountKey, guidKey, itemEntry, delta);
+  std::shared_ptr<ListenerMap const> listeners;
+  {
+    std::lock_guard<std::mutex> guard(m_listenerLock);
+    listeners = m_listeners;
+  }
+  for (auto const &[id, listener] : *listeners)
+    listener(accountKey, guidKey, itemEntry, delta);
+}
+
+void ReagentBankLedger::Update(uint32 diff)
+{
+  {
+    std::lock_guard<std::mutex> guard(m_queryLock);
+    m_queryProcessor.ProcessReadyCallbacks();
+  }
+  ProcessCommits();
+  m_flushTimer += diff;
+  if (m_flushTimer < GetReagentBankSettings()->flushInterval &&
+      GetPendingCount() < LEDGER_EARLY_FLUSH_ROWS)
+    return;
+  m_flushTimer = 0;
+  Flush();
+}
+
+// Applies increments as multi-row additive upserts and decrements as
+// set-based conditional updates that never take a row below zero, then drops
+// the rows that were emptied
+void ReagentBankLedger::Write(PendingMap const &pending,
+                              std::set<OwnerKey> const &rehydrate, bool sync)
+{
+  if (pending.empty() && rehydrate.empty())
+    return;
+  auto trans = CharacterDatabase.BeginTransaction();
+  for (auto const &[accountKey, guidKey] : rehydrate)
+    sReagentBankArchive->AppendRehydrate(trans, accountKey, guidKey);
+  std::set<OwnerKey> drainedOwners;
+  std::ostringstream increments;
+  std::ostringstream decrements;
+  uint32 incrementRows = 0;
+  uint32 decrementRows = 0;
+  auto appendIncrements = [&]()
+  {
+    increments << " ON DUPLICATE KEY UPDATE amount = amount + VALUES(amount)";
+    trans->Append(increments.str());
+    increments.str("");
+    incrementRows = 0;
+  };
+  // Writes of an owner are ordered and debits are reserved against the
+  // cached amount, so a debit never exceeds the stored row. Should one
+  // anyway (rows changed behind the ledger's back), the row is clamped at
+  // zero and the missing part is quarantined instead of dropping the debit.
+  uint32 now = uint32(GameTime::GetGameTime().count());
+  auto appendDecrements = [&]()
+  {
+    std::string rows = decrements.str();
+    std::ostringstream shortfall;
+    shortfall << "INSERT INTO mod_reagent_bank_account_quarantine (account_id, guid, item_entry, item_subclass, amount, reason, quarantined_at) "
+                 "SELECT d.account_id, d.guid, d.item_entry, d.item_subclass, d.amount - COALESCE(b.amount, 0), "
+              << uint32(QUARANTINE_DEBIT_SHORTFALL) << ", " << now << " FROM (" << rows
+              << ") d LEFT JOIN mod_reagent_bank_account b ON b.account_id = d.account_id AND b.guid = d.guid AND b.item_entry = d.item_entry"
+                 " WHERE COALESCE(b.amount, 0) < d.amount";
+    trans->Append(shortfall.str());
+    trans->Append("UPDATE mod_reagent_bank_account b JOIN (" + rows +
+                  ") d ON b.account_id = d.account_id AND b.guid = d.guid AND b.item_entry = d.item_entry"
+                  " SET b.amount = IF(b.amount > d.amount, b.amount - d.amount, 0)");
+    decrements.str("");
+    decrementRows = 0;
+  };
+  for (auto const &[key, change] : pending)
+  {
+    if (change.delta > 0)
+    {
+      increments << (incrementRows == 0 ? "INSERT INTO mod_reagent_bank_account (account_id, guid, item_entry, item_subclass, amount) VALUES "
+                                        : ", ")
+                 << "(" << std::get<0>(key) << ", " << std::get<1>(key)
+                 << ", " << std::get<2>(key) << ", " << change.itemSubclass
+                 << ", " << change.delta << ")";
+      if (++incrementRows == LEDGER_ROWS_PER_STATEMENT)
+        appendIncrements();
+      continue;
+    }
+    if (decrementRows == 0)
+      decrements << "SELECT " << std::get<0>(key) << " AS account_id, "
+                 << std::get<1>(key) << " AS guid, " << std::get<2>(key)
+                 << " AS item_entry, " << change.itemSubclass
+                 << " AS item_subclass, " << -change.delta << " AS amount";
+    else
+      decrements << " UNION ALL SELECT " << std::get<0>(key) << ", "
+                 << std::get<1>(key) << ", " << std::get<2>(key) << ", "
+                 << change.itemSubclass << ", " << -change.delta;
+    drainedOwners.emplace(std::get<0>(key), std::get<1>(key));
+    if (++decrementRows == LEDGER_ROWS_PER_STATEMENT)
+      appendDecrements();
+  }
+  if (incrementRows > 0)
+    appendIncrements();
+  if (decrementRows > 0)
+    appendDecrements();
+  for (auto const &[accountKey, guidKey] : drainedOwners)
+    trans->Append("DELETE FROM mod_reagent_bank_account WHERE account_id = {} AND guid = {} AND amount <= 0",
+                  accountKey, guidKey);
+  if (sync)
+  {
+    CharacterDatabase.DirectCommitTransaction(trans);
+    LoadList loads;
+    EndWrite(pending, rehydrate, loads);
+    for (auto const &[owner, loadId] : loads)
+      IssueLoad(owner, loadId);
+    return;
+  }
+  std::lock_guard<std::mutex> guard(m_commitLock);
+  m_commitProcessor.AddCallback(CharacterDatabase.AsyncCommitTransaction(trans))
+      .AfterComplete([this, pending, rehydrate](bool success)
+                     { OnWriteCommitted(pending, rehydrate, success); });
+}
+
+// Runs under m_commitLock. A failed write goes back into the buffer (the
+// cached amounts already include it) and is retried with the next one.
+void ReagentBankLedger::OnWriteCommitted(PendingMap const &pending,
+                                         std::set<OwnerKey> const &rehydrate,
+                                         bool success)
+{
+  if (!success)
+  {
+    LOG_ERROR("module",
+              "ReagentBankAccount: writing {} reagent bank changes failed, "
+              "retrying with the next write",
+              pending.size());
+    for (auto const &[key, change] : pending)
+    {
+      Shard &shard = GetShard(std::get<0>(key), std::get<1>(key));
+      std::lock_guard<std::mutex> guard(shard.lock);
+      QueueDeltaLocked(shard, key, change.itemSubclass, change.delta);
+    }
+    for (OwnerKey const &owner : rehydrate)
+    {
+      Shard &shard = GetShard(owner.first, owner.second);
+      std::lock_guard<std::mutex> guard(shard.lock);
+      shard.rehydrate.insert(owner);
+    }
+  }
+  EndWrite(pending, rehydrate, m_deferredLoads);
+}
+
+// Clears the write in flight of every owner of the write and collects the
+// loads that were waiting for it
+void ReagentBankLedger::EndWrite(PendingMap const &pending,
+                                 std::set<OwnerKey> const &rehydrate,
+                                 LoadList &loads)
+{
+  std::set<OwnerKey> owners = rehydrate;
+  for (auto const &[key, change] : pending)
+    owners.emplace(std::get<0>(key), std::get<1>(key));
+  for (OwnerKey const &owner : owners)
+  {
+    Shard &shard = GetShard(owner.first, owner.second);
+    std::lock_guard<std::mutex> guard(shard.lock);
+    auto writing = shard.writing.find(owner);
+    if (writing == shard.writing.end() || --writing->second > 0)
+      continue;
+    shard.writing.erase(writing);
+    auto it = shard.owners.find(owner);
+    if (it != shard.owners.end() && it->second.loadDeferred)
+    {
+      it->second.loadDeferred = false;
+      loads.emplace_back(owner, it->second.loadId);
+    }
+  }
+}
+
+// Completes the writes that have committed. Callable from any thread; the
+// released loads are issued after m_commitLock is dropped, since load
+// callbacks take the locks in the opposite order.
+void ReagentBankLedger::ProcessCommits()
+{
+  LoadList loads;
+  {
+    std::lock_guard<std::mutex> guard(m_commitLock);
+    m_commitProcessor.ProcessReadyCallbacks();
+    loads.swap(m_deferredLoads);
+  }
+  for (auto const &[owner, loadId] : loads)
+    IssueLoad(owner, loadId);
+}
+
+// Blocks until the owner has no write in flight
+void ReagentBankLedger::WaitForWrites(OwnerKey const &owner)
+{
+  Shard &shard = GetShard(owner.first, owner.second);
+  while (true)
+  {
+    {
+      std::lock_guard<std::mutex> guard(shard.lock);
+      if (!IsWritingLocked(shard, owner))
+        return;
+    }
+    ProcessCommits();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+}
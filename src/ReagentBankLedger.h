@@ -0,0 +1,190 @@
+#ifndef AZEROTHCORE_REAGENTBANKLEDGER_H
+#define AZEROTHCORE_REAGENTBANKLEDGER_H
+#include "AsyncCallbackProcessor.h"
+#include "DatabaseEnvFwd.h"
+#include "Define.h"
+#include <array>
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#define LEDGER_ROWS_PER_STATEMENT 256 // Rows per multi-row upsert
+#define LEDGER_EARLY_FLUSH_ROWS 4096  // Pending rows that trigger a flush
+#define LEDGER_SHARD_COUNT 16         // Independently locked owner shards
+#define LEDGER_SHUTDOWN_WAIT 30000    // ms to wait for writes on shutdown
+
+// Write-behind buffer for reagent bank amounts. Every change to a stored
+// amount is queued as a signed delta and written later as additive upserts,
+// so changes coming from different paths (banker, loot, ...) commute and
+// never overwrite each other.
+//
+// Owners with an online character also get an in-memory copy of their
+// stored amounts, kept in step with every queued delta, so hot paths such
+// as spell casts can look amounts up without touching the database. While
+// an owner is loaded that copy is authoritative: withdrawals reserve from it
+// atomically with TakeCached, which is what keeps a shared (guild) ledger
+// from handing the same reagents out twice.
+//
+// Owners are spread over LEDGER_SHARD_COUNT shards with their own lock, so
+// map threads working on different owners never wait for each other.
+//
+// Writes of one owner are strictly ordered: an owner has at most one write
+// in flight, its later changes wait in the buffer until that write has
+// committed, and an owner's rows are only read from the DB once none of its
+// writes is in flight. Writes of different owners touch different rows and
+// are not ordered against each other.
+class ReagentBankLedger
+{
+public:
+  static ReagentBankLedger *instance();
+
+  // Queues a change of a stored amount; merged with earlier pending changes
+  void QueueDelta(uint32 accountKey, uint32 guidKey, uint32 itemEntry,
+                  uint32 itemSubclass, int32 delta);
+
+  // Writes the pending changes of every owner without a write in flight in
+  // one asynchronous transaction. With `sync` (shutdown) it first waits for
+  // the writes in flight and then writes everything before returning.
+  void Flush(bool sync = false);
+
+  // Waits for the owner's write in flight and writes its pending changes
+  // before returning, used before reading that owner's rows from the DB
+  void FlushOwner(uint32 accountKey, uint32 guidKey);
+
+  std::size_t GetPendingCount() const;
+
+  // True while any write is in flight, e.g. one started by Flush
+  bool HasWritesInFlight() const;
+
+  // True while the owner is loaded or has changes waiting to be written or
+  // being written
+  bool IsOwnerInUse(uint32 accountKey, uint32 guidKey) const;
+
+  // Reference-counted in-memory copy of an owner's rows, loaded
+  // asynchronously by the first Acquire and dropped by the last Release.
+  // Changes still pending on release go out with the next periodic write.
+  // Acquiring marks the owner active; archived rows found by the load are
+  // moved back by the owner's next write. `onLoaded` runs once the owner is
+  // loaded: right away if it already is, otherwise on the thread completing
+  // the load (the world thread, unless AcquireOwnerNow gets there first).
+  void AcquireOwner(uint32 accountKey, uint32 guidKey,
+                    std::function<void()> onLoaded = nullptr);
+  void ReleaseOwner(uint32 accountKey, uint32 guidKey);
+
+  // Like AcquireOwner, but the rows are loaded before returning (one query,
+  // plus waiting for the owner's write in flight). Used when a mutation
+  // needs an owner that is not (yet) loaded.
+  void AcquireOwnerNow(uint32 accountKey, uint32 guidKey);
+
+  // Re-reads a loaded owner's rows (asynchronously) after they were changed
+  // behind the ledger's back (e.g. by a migration); changes queued
+  // meanwhile are kept
+  void ReloadOwner(uint32 accountKey, uint32 guidKey);
+
+  // O(1) lookup of a stored amount; false if the owner is not loaded
+  bool GetCachedAmount(uint32 accountKey, uint32 guidKey, uint32 itemEntry,
+                       uint32 &amount) const;
+
+  // Copies all amounts of a loaded owner; false if the owner is not loaded
+  bool GetCachedAmounts(uint32 accountKey, uint32 guidKey,
+                        std::unordered_map<uint32, uint32> &amounts) const;
+
+  // Atomically takes up to `wanted` from a loaded owner and queues the
+  // decrement. Returns the amount taken (0 if the owner is not loaded).
+  uint32 TakeCached(uint32 accountKey, uint32 guidKey, uint32 itemEntry,
+                    uint32 itemSubclass, uint32 wanted);
+
+  // Change listeners, called after every queued delta outside the ledger
+  // lock: (account_id, guid, item_entry, delta). A listener removed while a
+  // change is being reported may still be called for that change.
+  typedef std::function<void(uint32, uint32, uint32, int32)> ChangeListener;
+  uint32 AddListener(ChangeListener listener);
+  void RemoveListener(uint32 id);
+
+  // Runs load and write callbacks and the periodic flush (world thread)
+  void Update(uint32 diff);
+
+private:
+  // (account_id, guid, item_entry)
+  typedef std::tuple<uint32, uint32, uint32> LedgerKey;
+  // (account_id, guid)
+  typedef std::pair<uint32, uint32> OwnerKey;
+  struct PendingDelta
+  {
+    uint32 itemSubclass;
+    int32 delta;
+  };
+  typedef std::map<LedgerKey, PendingDelta> PendingMap;
+  struct OwnerLedger
+  {
+    uint32 refCount = 0;
+    bool loaded = false;
+    uint32 loadId = 0; // Tells a stale load callback from the current one
+    bool loadDeferred = false; // Load waits for the owner's write in flight
+    std::vector<std::function<void()>> onLoaded; // Run once loaded
+    std::unordered_map<uint32, uint32> amounts; // item_entry -> amount
+  };
+  struct Shard
+  {
+    mutable std::mutex lock;
+    PendingMap pending;
+    std::map<OwnerKey, OwnerLedger> owners;
+    std::map<OwnerKey, uint32> writing; // Owners with a write in flight
+    // Owners whose load found archived rows; the next write of the owner
+    // moves them back into the hot table before its own changes
+    std::set<OwnerKey> rehydrate;
+  };
+  typedef std::vector<std::pair<OwnerKey, uint32>> LoadList;
+
+  Shard &GetShard(uint32 accountKey, uint32 guidKey);
+  Shard const &GetShard(uint32 accountKey, uint32 guidKey) const;
+  static void QueueDeltaLocked(Shard &shard, LedgerKey const &key,
+                               uint32 itemSubclass, int32 delta);
+  static void ApplyToCacheLocked(Shard &shard, LedgerKey const &key,
+                                 int32 delta);
+  static bool IsLoadingLocked(Shard const &shard, OwnerKey const &owner);
+  static bool IsWritingLocked(Shard const &shard, OwnerKey const &owner);
+  static std::string BuildLoadQuery(OwnerKey const &owner);
+  void IssueLoad(OwnerKey const &owner, uint32 loadId);
+  void OnOwnerLoaded(OwnerKey const &owner, uint32 loadId,
+                     QueryResult result);
+  bool ApplyLoadLocked(Shard &shard, OwnerKey const &owner, uint32 loadId,
+                       QueryResult result);
+  void Write(PendingMap const &pending, std::set<OwnerKey> const &rehydrate,
+             bool sync);
+  void OnWriteCommitted(PendingMap const &pending,
+                        std::set<OwnerKey> const &rehydrate, bool success);
+  void EndWrite(PendingMap const &pending,
+                std::set<OwnerKey> const &rehydrate, LoadList &loads);
+  void ProcessCommits();
+  void WaitForWrites(OwnerKey const &owner);
+  void Notify(uint32 accountKey, uint32 guidKey, uint32 itemEntry,
+              int32 delta) const;
+
+  std::array<Shard, LEDGER_SHARD_COUNT> m_shards;
+  std::mutex m_queryLock; // Guards m_queryProcessor (login and map threads)
+  QueryCallbackProcessor m_queryProcessor;
+  std::mutex m_commitLock; // Guards m_commitProcessor and m_deferredLoads
+  AsyncCallbackProcessor<TransactionCallback> m_commitProcessor;
+  LoadList m_deferredLoads; // Loads released by completed writes
+  uint32 m_flushTimer = 0;
+  std::atomic<uint32> m_nextLoadId{0};
+  // Replaced (copy on write) by AddListener/RemoveListener; Notify calls a
+  // snapshot outside the lock, so changes never wait on each other
+  typedef std::map<uint32, ChangeListener> ListenerMap;
+  mutable std::mutex m_listenerLock;
+  std::shared_ptr<ListenerMap const> m_listeners =
+      std::make_shared<ListenerMap const>();
+  uint32 m_nextListenerId = 0;
+};
+
+#define sReagentBankLedger ReagentBankLedger::instance()
+
+#endif // AZEROTHCORE_REAGENTBANKLEDGER_H
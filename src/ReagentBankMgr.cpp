@@ -0,0 +1,302 @@
+#include "ReagentBankMgr.h"
+#include "DatabaseEnv.h"
+#include "GameTime.h"
+#include "ReagentBankAccount.h"
+#include "ReagentBankAudit.h"
+#include "ReagentBankLedger.h"
+#include <algorithm>
+#include <limits>
+
+ReagentBankMgr *ReagentBankMgr::instance()
+{
+  static ReagentBankMgr instance;
+  return &instance;
+}
+
+ReagentBankOwner ReagentBankMgr::GetOwner(Player *player) const
+{
+  ReagentBankOwner owner;
+  GetStorageKeys(player, owner.accountKey, owner.guidKey);
+  return owner;
+}
+
+uint32 ReagentBankMgr::GetAmount(ReagentBankOwner const &owner,
+                                 uint32 itemEntry) const
+{
+  uint32 amount;
+  if (sReagentBankLedger->GetCachedAmount(owner.accountKey, owner.guidKey,
+                                          itemEntry, amount))
+    return amount;
+  sReagentBankLedger->FlushOwner(owner.accountKey, owner.guidKey);
+  QueryResult result = CharacterDatabase.Query(
+      "SELECT amount FROM mod_reagent_bank_account WHERE account_id = {0} AND guid = {1} AND item_entry = {2} "
+      "UNION ALL SELECT amount FROM mod_reagent_bank_account_cold WHERE account_id = {0} AND guid = {1} AND item_entry = {2}",
+      owner.accountKey, owner.guidKey, itemEntry);
+  uint32 amount = 0;
+  if (result)
+  {
+    do
+    {
+      amount += (*result)[0].Get<uint32>();
+    } while (result->NextRow());
+  }
+  return amount;
+}
+
+std::vector<ReagentBankEntry>
+ReagentBankMgr::ListByCategory(ReagentBankOwner const &owner,
+                               uint32 itemSubclass) const
+{
+  std::vector<ReagentBankEntry> entries;
+  std::unordered_map<uint32, uint32> amounts;
+  if (sReagentBankLedger->GetCachedAmounts(owner.accountKey, owner.guidKey,
+                                           amounts))
+  {
+    for (auto const &[itemEntry, amount] : amounts)
+    {
+      ItemTemplate const *itemTemplate = sObjectMgr->GetItemTemplate(itemEntry);
+      if (itemTemplate && GetReagentSubclass(itemTemplate) == itemSubclass)
+        entries.push_back({itemEntry, itemSubclass, amount});
+    }
+    return entries;
+  }
+  sReagentBankLedger->FlushOwner(owner.accountKey, owner.guidKey);
+  QueryResult result = CharacterDatabase.Query(
+      "SELECT item_entry, amount FROM mod_reagent_bank_account WHERE account_id = {0} AND guid = {1} AND item_subclass = {2} "
+      "UNION ALL SELECT item_entry, amount FROM mod_reagent_bank_account_cold WHERE account_id = {0} AND guid = {1} AND item_subclass = {2}",
+      owner.accountKey, owner.guidKey, itemSubclass);
+  if (result)
+  {
+    do
+    {
+      amounts[(*result)[0].Get<uint32>()] += (*result)[1].Get<uint32>();
+    } while (result->NextRow());
+  }
+  for (auto const &[itemEntry, amount] : amounts)
+    entries.push_back({itemEntry, itemSubclass, amount});
+  return entries;
+}
+
+std::vector<ReagentBankEntry>
+ReagentBankMgr::ListAll(ReagentBankOwner const &owner) const
+{
+  std::vector<ReagentBankEntry> entries;
+  std::unordered_map<uint32, uint32> amounts;
+  if (sReagentBankLedger->GetCachedAmounts(owner.accountKey, owner.guidKey,
+                                           amounts))
+  {
+    entries.reserve(amounts.size());
+    for (auto const &[itemEntry, amount] : amounts)
+    {
+      ItemTemplate const *itemTemplate = sObjectMgr->GetItemTemplate(itemEntry);
+      if (itemTemplate)
+        entries.push_back(
+            {itemEntry, GetReagentSubclass(itemTemplate), amount});
+    }
+    return entries;
+  }
+  sReagentBankLedger->FlushOwner(owner.accountKey, owner.guidKey);
+  QueryResult result = CharacterDatabase.Query(
+      "SELECT item_entry, MAX(item_subclass), SUM(amount) FROM ("
+      "SELECT item_entry, item_subclass, amount FROM mod_reagent_bank_account WHERE account_id = {0} AND guid = {1} "
+      "UNION ALL SELECT item_entry, item_subclass, amount FROM mod_reagent_bank_account_cold WHERE account_id = {0} AND guid = {1}"
+      ") t GROUP BY item_entry",
+      owner.accountKey, owner.guidKey);
+  if (result)
+  {
+    do
+    {
+      entries.push_back({(*result)[0].Get<uint32>(),
+                         (*result)[1].Get<uint32>(),
+                         (*result)[2].Get<uint32>()});
+    } while (result->NextRow());
+  }
+  return entries;
+}
+
+std::map<uint32, uint32>
+ReagentBankMgr::DepositItems(Player *player, std::vector<Item *> const &items)
+{
+  std::map<uint32, uint32> deposited;
+  ReagentBankAuditScope audit(player, AUDIT_OP_DEPOSIT);
+  ReagentBankOwner owner = GetOwner(player);
+  for (Item *item : items)
+  {
+    if (!item || item->GetOwnerGUID() != player->GetGUID())
+      continue;
+    ItemTemplate const *itemTemplate = item->GetTemplate();
+    if (!IsReagent(itemTemplate))
+      continue;
+    uint32 count = item->GetCount();
+    deposited[itemTemplate->ItemId] += count;
+    sReagentBankLedger->QueueDelta(owner.accountKey, owner.guidKey,
+                                   itemTemplate->ItemId,
+                                   GetReagentSubclass(itemTemplate),
+                                   static_cast<int32>(count));
+    player->DestroyItem(item->GetBagSlot(), item->GetSlot(), true);
+  }
+  return deposited;
+}
+
+void ReagentBankMgr::Deposit(ReagentBankOwner const &owner,
+                             std::map<uint32, uint32> const &amounts)
+{
+  for (auto const &[itemEntry, count] : amounts)
+  {
+    ItemTemplate const *itemTemplate = sObjectMgr->GetItemTemplate(itemEntry);
+    if (!itemTemplate || !IsReagent(itemTemplate) || count == 0)
+      continue;
+    sReagentBankLedger->QueueDelta(owner.accountKey, owner.guidKey, itemEntry,
+                                   GetReagentSubclass(itemTemplate),
+                                   static_cast<int32>(count));
+  }
+}
+
+uint32 ReagentBankMgr::GetGuildAllowance(Player *player,
+                                         ReagentBankOwner const &owner)
+{
+  uint32 limit = GetReagentBankSettings()->guildDailyWithdrawLimit;
+  if (!IsGuildOwnerKey(owner.accountKey) || limit == 0)
+    return std::numeric_limits<uint32>::max();
+  uint32 day = uint32(GameTime::GetGameTime().count() / DAY);
+  std::lock_guard<std::mutex> guard(m_guildWithdrawLock);
+  auto it = m_guildWithdrawn.find(player->GetGUID().GetCounter());
+  if (it == m_guildWithdrawn.end() || it->second.first != day)
+    return limit;
+  return limit - std::min(limit, it->second.second);
+}
+
+void ReagentBankMgr::ChargeGuildAllowance(Player *player,
+                                          ReagentBankOwner const &owner,
+                                          uint32 count)
+{
+  if (!IsGuildOwnerKey(owner.accountKey) ||
+      GetReagentBankSettings()->guildDailyWithdrawLimit == 0 || count == 0)
+    return;
+  uint32 day = uint32(GameTime::GetGameTime().count() / DAY);
+  std::lock_guard<std::mutex> guard(m_guildWithdrawLock);
+  auto &withdrawn = m_guildWithdrawn[player->GetGUID().GetCounter()];
+  if (withdrawn.first != day)
+    withdrawn = {day, 0};
+  withdrawn.second += count;
+}
+
+InventoryResult
+ReagentBankMgr::Withdraw(Player *player,
+                         std::map<uint32, uint32> const &requests,
+                         std::map<uint32, uint32> &withdrawn,
+                         bool cachedOnly)
+{
+  ReagentBankAuditScope audit(player, AUDIT_OP_WITHDRAW);
+  ReagentBankOwner owner = GetOwner(player);
+  // Reservations need the in-memory ledger; hold it for the duration if no
+  // character of the owner is online (or its login load is still pending)
+  uint32 probe;
+  bool acquired = !sReagentBankLedger->GetCachedAmount(
+      owner.accountKey, owner.guidKey, 0, probe);
+  if (acquired && cachedOnly)
+    return EQUIP_ERR_OK;
+  if (acquired)
+    sReagentBankLedger->AcquireOwnerNow(owner.accountKey, owner.guidKey);
+
+  InventoryResult result = EQUIP_ERR_OK;
+  for (auto const &[itemEntry, wanted] : requests)
+  {
+    ItemTemplate const *itemTemplate = sObjectMgr->GetItemTemplate(itemEntry);
+    if (!itemTemplate || wanted == 0)
+      continue;
+    uint32 allowance = GetGuildAllowance(player, owner);
+    if (allowance == 0)
+    {
+      ChatHandler(player->GetSession())
+          .SendSysMessage("You have reached today's guild reagent withdrawal limit.");
+      break;
+    }
+    uint32 itemSubclass = GetReagentSubclass(itemTemplate);
+    uint32 taken = sReagentBankLedger->TakeCached(
+        owner.accountKey, owner.guidKey, itemEntry, itemSubclass,
+        std::min(wanted, allowance));
+    uint32 stackSize = itemTemplate->GetMaxStackSize();
+    uint32 givenTotal = 0;
+    while (givenTotal < taken)
+    {
+      uint32 toGive = std::min(stackSize, taken - givenTotal);
+      ItemPosCountVec dest;
+      InventoryResult msg = player->CanStoreNewItem(NULL_BAG, NULL_SLOT, dest,
+                                                    itemEntry, toGive);
+      if (msg != EQUIP_ERR_OK)
+      {
+        player->SendEquipError(msg, nullptr, nullptr, itemEntry);
+        if (result == EQUIP_ERR_OK)
+          result = msg;
+        break;
+      }
+      Item *item = player->StoreNewItem(dest, itemEntry, true);
+      player->SendNewItem(item, toGive, true, false);
+      givenTotal += toGive;
+    }
+    // Put back what did not fit
+    if (givenTotal < taken)
+      sReagentBankLedger->QueueDelta(owner.accountKey, owner.guidKey,
+                                     itemEntry, itemSubclass,
+                                     static_cast<int32>(taken - givenTotal));
+    if (givenTotal > 0)
+    {
+      withdrawn[itemEntry] = givenTotal;
+      ChargeGuildAllowance(player, owner, givenTotal);
+    }
+  }
+
+  if (acquired)
+    sReagentBankLedger->ReleaseOwner(owner.accountKey, owner.guidKey);
+  return result;
+}
+
+void ReagentBankMgr::WhenLoaded(ReagentBankOwner const &owner,
+                                std::function<void()> read) const
+{
+  sReagentBankLedger->AcquireOwner(
+      owner.accountKey, owner.guidKey, [owner, read = std::move(read)]()
+      {
+        read();
+        sReagentBankLedger->ReleaseOwner(owner.accountKey, owner.guidKey);
+      });
+}
+
+void ReagentBankMgr::GetAmountAsync(
+    ReagentBankOwner const &owner, uint32 itemEntry,
+    std::function<void(uint32 amount)> callback) const
+{
+  WhenLoaded(owner, [this, owner, itemEntry, callback = std::move(callback)]()
+             { callback(GetAmount(owner, itemEntry)); });
+}
+
+void ReagentBankMgr::ListByCategoryAsync(
+    ReagentBankOwner const &owner, uint32 itemSubclass,
+    std::function<void(std::vector<ReagentBankEntry> entries)> callback) const
+{
+  WhenLoaded(owner,
+             [this, owner, itemSubclass, callback = std::move(callback)]()
+             { callback(ListByCategory(owner, itemSubclass)); });
+}
+
+void ReagentBankMgr::ListAllAsync(
+    ReagentBankOwner const &owner,
+    std::function<void(std::vector<ReagentBankEntry> entries)> callback) const
+{
+  WhenLoaded(owner, [this, owner, callback = std::move(callback)]()
+             { callback(ListAll(owner)); });
+}
+
+uint32 ReagentBankMgr::Subscribe(ReagentBankListener listener)
+{
+  return sReagentBankLedger->AddListener(
+      [listener](uint32 accountKey, uint32 guidKey, uint32 itemEntry,
+                 int32 delta)
+      { listener(ReagentBankOwner{accountKey, guidKey}, itemEntry, delta); });
+}
+
+void ReagentBankMgr::Unsubscribe(uint32 id)
+{
+  sReagentBankLedger->RemoveListener(id);
+}
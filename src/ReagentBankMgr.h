@@ -0,0 +1,130 @@
+#ifndef AZEROTHCORE_REAGENTBANKMGR_H
+#define AZEROTHCORE_REAGENTBANKMGR_H
+#include "Define.h"
+#include "Item.h"
+#include <functional>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+class Player;
+
+// Key a reagent bank is stored under (the account_id and guid columns of
+// mod_reagent_bank_account). See GetStorageKeys for how a player maps to it.
+struct ReagentBankOwner
+{
+  uint32 accountKey;
+  uint32 guidKey;
+};
+
+struct ReagentBankEntry
+{
+  uint32 itemEntry;
+  uint32 itemSubclass;
+  uint32 amount;
+};
+
+// Called for every change of a stored amount with the signed delta. Runs on
+// the thread making the change, concurrently with other changes.
+typedef std::function<void(ReagentBankOwner const &owner, uint32 itemEntry,
+                           int32 delta)>
+    ReagentBankListener;
+
+// Public API of the reagent bank for other modules. All changes go through
+// the module's write-behind ledger: they are visible to every reader at once
+// and reach the database in the next batched write.
+//
+//   ReagentBankOwner owner = sReagentBankMgr->GetOwner(player);
+//   uint32 stored = sReagentBankMgr->GetAmount(owner, 2589);
+class ReagentBankMgr
+{
+public:
+  static ReagentBankMgr *instance();
+
+  // Owner the player's reagents are stored under in the current mode
+  ReagentBankOwner GetOwner(Player *player) const;
+
+  // Stored amount of one item. O(1) while the owner is in memory (one of its
+  // characters is online). Otherwise this BLOCKS the calling thread: it waits
+  // for the owner's write in flight, commits the owner's queued changes
+  // synchronously and then runs a query. Use GetAmountAsync for owners that
+  // may not be loaded.
+  uint32 GetAmount(ReagentBankOwner const &owner, uint32 itemEntry) const;
+
+  // Everything stored in one category (an ITEM_SUBCLASS_* value, gems are
+  // listed under ITEM_SUBCLASS_JEWELCRAFTING), in no particular order.
+  // Blocks and may write like GetAmount when the owner is not in memory.
+  std::vector<ReagentBankEntry> ListByCategory(ReagentBankOwner const &owner,
+                                               uint32 itemSubclass) const;
+
+  // Everything stored by the owner, in no particular order, for bulk
+  // operations that would otherwise list every category. Blocks and may
+  // write like GetAmount when the owner is not in memory.
+  std::vector<ReagentBankEntry> ListAll(ReagentBankOwner const &owner) const;
+
+  // Non-blocking variants: the callback runs at once if the owner is in
+  // memory, otherwise once its rows are loaded (on the world thread). The
+  // owner is kept loaded until the callback returns.
+  void GetAmountAsync(ReagentBankOwner const &owner, uint32 itemEntry,
+                      std::function<void(uint32 amount)> callback) const;
+  void ListByCategoryAsync(
+      ReagentBankOwner const &owner, uint32 itemSubclass,
+      std::function<void(std::vector<ReagentBankEntry> entries)> callback)
+      const;
+  void ListAllAsync(
+      ReagentBankOwner const &owner,
+      std::function<void(std::vector<ReagentBankEntry> entries)> callback)
+      const;
+
+  // Moves the given items out of the player's inventory into the player's
+  // bank. Items that are not reagents or not owned by the player are
+  // skipped. Returns item entry -> deposited count.
+  std::map<uint32, uint32> DepositItems(Player *player,
+                                        std::vector<Item *> const &items);
+
+  // Credits amounts (item entry -> count) to an owner without touching any
+  // inventory, e.g. for items taken from mail. Non-reagents are skipped.
+  void Deposit(ReagentBankOwner const &owner,
+               std::map<uint32, uint32> const &amounts);
+
+  // Moves up to the requested amounts (item entry -> count) from the
+  // player's bank into the bags. An item that does not fit is skipped and
+  // the next one is tried, so smaller stacks still go in. `withdrawn`
+  // receives item entry -> count actually moved; the result is EQUIP_ERR_OK
+  // unless something did not fit (the first error otherwise).
+  //
+  // Amounts are reserved atomically before the items are created, so
+  // characters sharing a bank (guild mode) can never withdraw the same
+  // reagents twice; whatever does not fit goes back to the bank. Guild
+  // members are capped by ReagentBankAccount.Guild.DailyWithdrawLimit.
+  //
+  // With `cachedOnly` nothing is read from the database: if the owner's
+  // ledger is not in memory yet, nothing is withdrawn (for spell casts).
+  InventoryResult Withdraw(Player *player,
+                           std::map<uint32, uint32> const &requests,
+                           std::map<uint32, uint32> &withdrawn,
+                           bool cachedOnly = false);
+
+  // Registers a change listener; returns an id for Unsubscribe
+  uint32 Subscribe(ReagentBankListener listener);
+  void Unsubscribe(uint32 id);
+
+private:
+  // Runs `read` with the owner's ledger loaded
+  void WhenLoaded(ReagentBankOwner const &owner,
+                  std::function<void()> read) const;
+
+  // Items the player may still take from a guild bank today
+  uint32 GetGuildAllowance(Player *player, ReagentBankOwner const &owner);
+  void ChargeGuildAllowance(Player *player, ReagentBankOwner const &owner,
+                            uint32 count);
+
+  std::mutex m_guildWithdrawLock;
+  // guidLow -> (day, items withdrawn that day); not kept across restarts
+  std::unordered_map<uint32, std::pair<uint32, uint32>> m_guildWithdrawn;
+};
+
+#define sReagentBankMgr ReagentBankMgr::instance()
+
+#endif // AZEROTHCORE_REAGENTBANKMGR_H
@@ -0,0 +1,256 @@
+#include "ReagentBankMigration.h"
+#include "DatabaseEnv.h"
+#include "Log.h"
+#include "ReagentBankAccount.h"
+#include "ReagentBankLedger.h"
+#include "StringFormat.h"
+#include <algorithm>
+
+ReagentBankMigration *ReagentBankMigration::instance()
+{
+  static ReagentBankMigration instance;
+  return &instance;
+}
+
+void ReagentBankMigration::LoadState()
+{
+  m_stateLoaded = true;
+  QueryResult result = CharacterDatabase.Query(
+      "SELECT direction, cursor_key, owners_moved, owners_skipped, paused FROM mod_reagent_bank_account_migration WHERE id = 1");
+  if (!result)
+    return;
+  Field *fields = result->Fetch();
+  m_direction = ReagentBankMigrationDirection(fields[0].Get<uint8>());
+  m_cursor = fields[1].Get<uint32>();
+  m_ownersMoved = fields[2].Get<uint32>();
+  m_ownersSkipped = fields[3].Get<uint32>();
+  bool paused = fields[4].Get<bool>();
+  bool modeMatches = (m_direction == MIGRATE_TO_ACCOUNT) == GetReagentBankSettings()->accountWide;
+  m_running = !paused && modeMatches;
+  if (!paused && !modeMatches)
+    LOG_WARN("module",
+             "ReagentBankAccount: saved migration does not match "
+             "ReagentBankAccount.AccountWide; not resuming it");
+  else if (m_running)
+    LOG_INFO("module", "ReagentBankAccount: resuming migration: {}",
+             GetStatus());
+}
+
+void ReagentBankMigration::SaveState(bool paused) const
+{
+  CharacterDatabase.Execute(
+      "REPLACE INTO mod_reagent_bank_account_migration (id, direction, cursor_key, owners_moved, owners_skipped, paused) VALUES (1, {}, {}, {}, {}, {})",
+      uint32(m_direction), m_cursor, m_ownersMoved, m_ownersSkipped,
+      paused ? 1 : 0);
+}
+
+bool ReagentBankMigration::Start(ReagentBankMigrationDirection direction,
+                                 std::string &message)
+{
+  if ((direction == MIGRATE_TO_ACCOUNT) != GetReagentBankSettings()->accountWide)
+  {
+    message = direction == MIGRATE_TO_ACCOUNT
+                  ? "Set ReagentBankAccount.AccountWide = 1 before migrating to account-wide storage."
+                  : "Set ReagentBankAccount.AccountWide = 0 before migrating to per-character storage.";
+    return false;
+  }
+  if (!m_stateLoaded)
+    LoadState();
+  if (m_running && m_direction == direction)
+  {
+    message = "Migration is already running. " + GetStatus();
+    return false;
+  }
+  if (m_batchInFlight)
+  {
+    message = "The previous migration batch is still being written, try again in a moment.";
+    return false;
+  }
+  if (m_direction != direction)
+  {
+    m_direction = direction;
+    m_cursor = 0;
+    m_ownersMoved = 0;
+    m_ownersSkipped = 0;
+  }
+  m_running = true;
+  m_timer = 0;
+  SaveState(false);
+  message = "Migration started. " + GetStatus();
+  return true;
+}
+
+// Only the paused flag is written, so a batch committing meanwhile keeps its
+// cursor
+void ReagentBankMigration::Pause()
+{
+  if (!m_running)
+    return;
+  m_running = false;
+  CharacterDatabase.Execute(
+      "UPDATE mod_reagent_bank_account_migration SET paused = 1 WHERE id = 1");
+}
+
+std::string ReagentBankMigration::GetStatus() const
+{
+  if (m_direction == MIGRATE_NONE)
+    return "No migration in progress.";
+  return Acore::StringFormat(
+      "Migration to {} rows {}: {} owners moved, {} skipped, cursor {}.",
+      m_direction == MIGRATE_TO_ACCOUNT ? "account" : "character",
+      m_running ? "running" : "paused", m_ownersMoved, m_ownersSkipped,
+      m_cursor);
+}
+
+void ReagentBankMigration::Update(uint32 diff)
+{
+  if (!m_stateLoaded)
+    LoadState();
+  m_queryProcessor.ProcessReadyCallbacks();
+  m_transactionProcessor.ProcessReadyCallbacks();
+  if (!m_running || m_batchInFlight)
+    return;
+  m_timer += diff;
+  if (m_timer < MIGRATION_BATCH_INTERVAL)
+    return;
+  m_timer = 0;
+
+  // Next batch of source owners in both tables, with the key each one
+  // moves to (NULL if it has no live character)
+  std::string cursor = std::to_string(m_cursor);
+  std::string query;
+  if (m_direction == MIGRATE_TO_ACCOUNT)
+    query = "SELECT o.guid, c.account FROM ("
+            "SELECT guid FROM mod_reagent_bank_account WHERE account_id = 0 AND guid > " + cursor +
+            " UNION SELECT guid FROM mod_reagent_bank_account_cold WHERE account_id = 0 AND guid > " + cursor +
+            " ORDER BY guid LIMIT " + std::to_string(MIGRATION_BATCH_OWNERS) +
+            ") o LEFT JOIN characters c ON c.guid = o.guid";
+  else
+    query = "SELECT o.account_id, (SELECT c.guid FROM characters c WHERE c.account = o.account_id "
+            "ORDER BY c.logout_time DESC, c.guid LIMIT 1) FROM ("
+            "SELECT account_id FROM mod_reagent_bank_account WHERE guid = 0 AND account_id > " + cursor +
+            " AND account_id < " + std::to_string(GUILD_OWNER_FLAG) +
+            " UNION SELECT account_id FROM mod_reagent_bank_account_cold WHERE guid = 0 AND account_id > " + cursor +
+            " AND account_id < " + std::to_string(GUILD_OWNER_FLAG) +
+            " ORDER BY account_id LIMIT " + std::to_string(MIGRATION_BATCH_OWNERS) +
+            ") o";
+  m_batchInFlight = true;
+  m_queryProcessor.AddCallback(
+      CharacterDatabase.AsyncQuery(query).WithCallback(
+          [this](QueryResult result) { OnBatchLoaded(result); }));
+}
+
+void ReagentBankMigration::OnBatchLoaded(QueryResult result)
+{
+  if (!result)
+  {
+    OnBatchCommitted(true, m_cursor, 0, 0, true, {});
+    return;
+  }
+  auto trans = CharacterDatabase.BeginTransaction();
+  std::vector<std::pair<uint32, uint32>> targets;
+  uint32 cursor = m_cursor;
+  uint32 rows = 0;
+  uint32 moved = 0;
+  uint32 skipped = 0;
+  // Source keys of the batch and the source -> target key pairs they move
+  // along, without owners in use or without a live character
+  std::string sources;
+  std::string mapping;
+  do
+  {
+    Field *fields = result->Fetch();
+    uint32 key = fields[0].Get<uint32>();
+    cursor = std::max(cursor, key);
+    ++rows;
+    std::pair<uint32, uint32> source = m_direction == MIGRATE_TO_ACCOUNT
+                                           ? std::make_pair(0u, key)
+                                           : std::make_pair(key, 0u);
+    uint32 targetKey = fields[1].IsNull() ? 0 : fields[1].Get<uint32>();
+    if (targetKey == 0 ||
+        sReagentBankLedger->IsOwnerInUse(source.first, source.second))
+    {
+      ++skipped;
+      continue;
+    }
+    if (!sources.empty())
+    {
+      sources += ", ";
+      mapping += " UNION ALL ";
+    }
+    sources += std::to_string(key);
+    mapping += Acore::StringFormat("SELECT {} AS source_key, {} AS target_key",
+                                   key, targetKey);
+    targets.push_back(m_direction == MIGRATE_TO_ACCOUNT
+                          ? std::make_pair(targetKey, 0u)
+                          : std::make_pair(0u, targetKey));
+    ++moved;
+  } while (result->NextRow());
+  // One grouped upsert and one delete per table for the whole batch;
+  // characters of one account moving together are summed up front
+  if (moved)
+  {
+    bool toAccount = m_direction == MIGRATE_TO_ACCOUNT;
+    char const *sourceColumn = toAccount ? "guid" : "account_id";
+    char const *otherColumn = toAccount ? "account_id" : "guid";
+    char const *target = toAccount ? "m.target_key AS account_id, 0 AS guid"
+                                   : "0 AS account_id, m.target_key AS guid";
+    for (char const *table :
+         {"mod_reagent_bank_account", "mod_reagent_bank_account_cold"})
+    {
+      trans->Append("INSERT INTO mod_reagent_bank_account (account_id, guid, item_entry, item_subclass, amount) "
+                    "SELECT * FROM (SELECT {0}, s.item_entry, MAX(s.item_subclass) AS item_subclass, SUM(s.amount) AS amount "
+                    "FROM {1} s JOIN ({2}) m ON m.source_key = s.{3} "
+                    "WHERE s.{4} = 0 AND s.{3} IN ({5}) GROUP BY m.target_key, s.item_entry) g "
+                    "ON DUPLICATE KEY UPDATE mod_reagent_bank_account.amount = mod_reagent_bank_account.amount + VALUES(amount)",
+                    target, table, mapping, sourceColumn, otherColumn,
+                    sources);
+      trans->Append("DELETE FROM {} WHERE {} = 0 AND {} IN ({})", table,
+                    otherColumn, sourceColumn, sources);
+    }
+  }
+  trans->Append("UPDATE mod_reagent_bank_account_migration SET cursor_key = {}, owners_moved = {}, owners_skipped = {} WHERE id = 1",
+                cursor, m_ownersMoved + moved, m_ownersSkipped + skipped);
+  bool last = rows < MIGRATION_BATCH_OWNERS;
+  m_transactionProcessor
+      .AddCallback(CharacterDatabase.AsyncCommitTransaction(trans))
+      .AfterComplete(
+          [this, cursor, moved, skipped, last, targets](bool success)
+          { OnBatchCommitted(success, cursor, moved, skipped, last, targets); });
+}
+
+void ReagentBankMigration::OnBatchCommitted(
+    bool success, uint32 cursor, uint32 moved, uint32 skipped, bool last,
+    std::vector<std::pair<uint32, uint32>> targets)
+{
+  m_batchInFlight = false;
+  if (!success)
+  {
+    LOG_ERROR("module",
+              "ReagentBankAccount: migration batch failed, migration paused. {}",
+              GetStatus());
+    Pause();
+    return;
+  }
+  m_cursor = cursor;
+  m_ownersMoved += moved;
+  m_ownersSkipped += skipped;
+  // Online owners that received rows see them without relogging
+  for (auto const &[accountKey, guidKey] : targets)
+    sReagentBankLedger->ReloadOwner(accountKey, guidKey);
+  if (!last)
+  {
+    LOG_INFO("module", "ReagentBankAccount: {}", GetStatus());
+    return;
+  }
+  m_running = false;
+  CharacterDatabase.Execute(
+      "DELETE FROM mod_reagent_bank_account_migration WHERE id = 1");
+  LOG_INFO("module",
+           "ReagentBankAccount: migration finished: {} owners moved, {} "
+           "skipped{}",
+           m_ownersMoved, m_ownersSkipped,
+           m_ownersSkipped ? " (run it again to retry owners that were in use)"
+                           : "");
+  m_direction = MIGRATE_NONE;
+}
@@ -0,0 +1,66 @@
+#ifndef AZEROTHCORE_REAGENTBANKMIGRATION_H
+#define AZEROTHCORE_REAGENTBANKMIGRATION_H
+#include "AsyncCallbackProcessor.h"
+#include "DatabaseEnvFwd.h"
+#include "Define.h"
+#include <string>
+#include <utility>
+#include <vector>
+
+#define MIGRATION_BATCH_OWNERS 200   // Owners moved per batch
+#define MIGRATION_BATCH_INTERVAL 200 // ms between batches
+
+// Direction column of mod_reagent_bank_account_migration
+enum ReagentBankMigrationDirection : uint8
+{
+  MIGRATE_NONE = 0,
+  MIGRATE_TO_ACCOUNT = 1,  // (0, guid) rows merged into (account, 0)
+  MIGRATE_TO_CHARACTER = 2 // (account, 0) rows moved to (0, guid) of the
+                           // account's most recently played character
+};
+
+// Online migration between the per-character and account-wide key patterns,
+// started with .reagentbank migrate. Owners are moved in keyset batches, one
+// short transaction per batch that copies each owner's rows (hot and
+// archived) onto the target key with additive upserts and deletes the
+// source rows. The cursor and counters are saved in the same transaction,
+// so an interrupted migration resumes where it stopped, also after a
+// restart. Owners that are in use are skipped and reported; running the
+// migration again picks them up.
+class ReagentBankMigration
+{
+public:
+  static ReagentBankMigration *instance();
+
+  // Starts a migration, or resumes the saved one in the same direction.
+  // Fails (with a message) if the mode in the config does not match.
+  bool Start(ReagentBankMigrationDirection direction, std::string &message);
+  void Pause();
+  std::string GetStatus() const;
+
+  // Drives the batches (world thread)
+  void Update(uint32 diff);
+
+private:
+  void LoadState();
+  void SaveState(bool paused) const;
+  void OnBatchLoaded(QueryResult result);
+  void OnBatchCommitted(bool success, uint32 cursor, uint32 moved,
+                        uint32 skipped, bool last,
+                        std::vector<std::pair<uint32, uint32>> targets);
+
+  QueryCallbackProcessor m_queryProcessor;
+  AsyncCallbackProcessor<TransactionCallback> m_transactionProcessor;
+  bool m_stateLoaded = false;
+  bool m_running = false;
+  bool m_batchInFlight = false;
+  uint32 m_timer = 0;
+  ReagentBankMigrationDirection m_direction = MIGRATE_NONE;
+  uint32 m_cursor = 0; // Last source guid (to account) or account (to character)
+  uint32 m_ownersMoved = 0;
+  uint32 m_ownersSkipped = 0;
+};
+
+#define sReagentBankMigration ReagentBankMigration::instance()
+
+#endif // AZEROTHCORE_REAGENTBANKMIGRATION_H
@@ -0,0 +1,152 @@
+#include "ReagentBankRepair.h"
+#include "DatabaseEnv.h"
+#include "GameTime.h"
+#include "Log.h"
+#include "ObjectMgr.h"
+#include "ReagentBankAccount.h"
+#include "ReagentBankLedger.h"
+#include <tuple>
+
+ReagentBankRepair *ReagentBankRepair::instance()
+{
+  static ReagentBankRepair instance;
+  return &instance;
+}
+
+void ReagentBankRepair::Update(uint32 diff)
+{
+  if (!GetReagentBankSettings()->repair)
+    return;
+  m_queryProcessor.ProcessReadyCallbacks();
+  if (m_chunkInFlight)
+    return;
+  m_timer += diff;
+  if (m_timer < (m_passRunning ? REPAIR_CHUNK_INTERVAL : REPAIR_PASS_INTERVAL))
+    return;
+  m_timer = 0;
+  if (!m_passRunning)
+  {
+    m_passRunning = true;
+    m_cursorAccount = 0;
+    m_cursorGuid = 0;
+    m_cursorItem = 0;
+    m_counts = Counts();
+  }
+  std::string account = std::to_string(m_cursorAccount);
+  std::string guid = std::to_string(m_cursorGuid);
+  m_chunkInFlight = true;
+  m_queryProcessor.AddCallback(
+      CharacterDatabase
+          .AsyncQuery("SELECT b.account_id, b.guid, b.item_entry, b.item_subclass, b.amount, c.guid FROM ("
+                      "SELECT account_id, guid, item_entry, item_subclass, amount FROM mod_reagent_bank_account "
+                      "WHERE account_id > " + account +
+                      " OR (account_id = " + account + " AND (guid > " + guid +
+                      " OR (guid = " + guid + " AND item_entry > " +
+                      std::to_string(m_cursorItem) +
+                      "))) ORDER BY account_id, guid, item_entry LIMIT " +
+                      std::to_string(REPAIR_CHUNK_ROWS) +
+                      ") b LEFT JOIN characters c ON b.account_id = 0 AND c.guid = b.guid")
+          .WithCallback([this](QueryResult result)
+                        { OnChunkLoaded(result); }));
+}
+
+// Every repair statement repeats the condition it was decided on, so a row
+// that changed since the chunk was read is left alone
+void ReagentBankRepair::OnChunkLoaded(QueryResult result)
+{
+  m_chunkInFlight = false;
+  uint32 rows = 0;
+  if (result)
+  {
+    auto trans = CharacterDatabase.BeginTransaction();
+    bool changed = false;
+    uint32 now = uint32(GameTime::GetGameTime().count());
+    do
+    {
+      Field *fields = result->Fetch();
+      uint32 accountKey = fields[0].Get<uint32>();
+      uint32 guidKey = fields[1].Get<uint32>();
+      uint32 itemEntry = fields[2].Get<uint32>();
+      uint32 itemSubclass = fields[3].Get<uint32>();
+      int32 amount = fields[4].Get<int32>();
+      bool orphaned = accountKey == 0 && guidKey != 0 && fields[5].IsNull();
+      ++rows;
+      ++m_counts.scanned;
+      if (std::make_tuple(accountKey, guidKey, itemEntry) >
+          std::make_tuple(m_cursorAccount, m_cursorGuid, m_cursorItem))
+        std::tie(m_cursorAccount, m_cursorGuid, m_cursorItem) =
+            std::make_tuple(accountKey, guidKey, itemEntry);
+
+      ItemTemplate const *itemTemplate = sObjectMgr->GetItemTemplate(itemEntry);
+      bool wrongSubclass =
+          itemTemplate && GetReagentSubclass(itemTemplate) != itemSubclass;
+      if (amount > 0 && itemTemplate && !orphaned && !wrongSubclass)
+        continue;
+      if (sReagentBankLedger->IsOwnerInUse(accountKey, guidKey))
+      {
+        ++m_counts.skippedInUse;
+        continue;
+      }
+      changed = true;
+      if (amount <= 0)
+      {
+        trans->Append("DELETE FROM mod_reagent_bank_account WHERE account_id = {} AND guid = {} AND item_entry = {} AND amount <= 0",
+                      accountKey, guidKey, itemEntry);
+        ++m_counts.nonPositive;
+      }
+      else if (!itemTemplate || orphaned)
+      {
+        uint8 reason =
+            itemTemplate ? QUARANTINE_ORPHANED_GUID : QUARANTINE_UNKNOWN_ITEM;
+        trans->Append("INSERT INTO mod_reagent_bank_account_quarantine (account_id, guid, item_entry, item_subclass, amount, reason, quarantined_at) "
+                      "SELECT account_id, guid, item_entry, item_subclass, amount, {}, {} FROM mod_reagent_bank_account "
+                      "WHERE account_id = {} AND guid = {} AND item_entry = {}",
+                      reason, now, accountKey, guidKey, itemEntry);
+        trans->Append("DELETE FROM mod_reagent_bank_account WHERE account_id = {} AND guid = {} AND item_entry = {}",
+                      accountKey, guidKey, itemEntry);
+        ++(itemTemplate ? m_counts.orphaned : m_counts.unknownItems);
+      }
+      else
+      {
+        trans->Append("UPDATE mod_reagent_bank_account SET item_subclass = {} WHERE account_id = {} AND guid = {} AND item_entry = {}",
+                      GetReagentSubclass(itemTemplate), accountKey, guidKey,
+                      itemEntry);
+        ++m_counts.subclassFixed;
+      }
+    } while (result->NextRow());
+    if (changed)
+      CharacterDatabase.CommitTransaction(trans);
+  }
+  if (rows < REPAIR_CHUNK_ROWS)
+  {
+    m_passRunning = false;
+    LOG_INFO("module",
+             "ReagentBankAccount: consistency check scanned {} rows: {} "
+             "non-positive removed, {} unknown items and {} orphaned rows "
+             "quarantined, {} categories fixed, {} skipped (owner in use)",
+             m_counts.scanned, m_counts.nonPositive, m_counts.unknownItems,
+             m_counts.orphaned, m_counts.subclassFixed,
+             m_counts.skippedInUse);
+    // Debits the ledger could not fully apply since the last report
+    uint32 now = uint32(GameTime::GetGameTime().count());
+    m_queryProcessor.AddCallback(
+        CharacterDatabase
+            .AsyncQuery("SELECT COUNT(*), CAST(COALESCE(SUM(amount), 0) AS SIGNED) FROM mod_reagent_bank_account_quarantine WHERE reason = " +
+                        std::to_string(uint32(QUARANTINE_DEBIT_SHORTFALL)) +
+                        " AND quarantined_at >= " +
+                        std::to_string(m_shortfallsReported) +
+                        " AND quarantined_at < " + std::to_string(now))
+            .WithCallback(
+                [](QueryResult result)
+                {
+                  if (result && (*result)[0].Get<uint64>() > 0)
+                    LOG_WARN("module",
+                             "ReagentBankAccount: {} reagent bank debits "
+                             "exceeded the stored amount ({} items missing), "
+                             "see mod_reagent_bank_account_quarantine reason 3",
+                             (*result)[0].Get<uint64>(),
+                             (*result)[1].Get<int64>());
+                }));
+    m_shortfallsReported = now;
+  }
+}
@@ -0,0 +1,67 @@
+#ifndef AZEROTHCORE_REAGENTBANKREPAIR_H
+#define AZEROTHCORE_REAGENTBANKREPAIR_H
+#include "AsyncCallbackProcessor.h"
+#include "DatabaseEnvFwd.h"
+#include "Define.h"
+
+#define REPAIR_CHUNK_ROWS 500         // Rows validated per chunk
+#define REPAIR_CHUNK_INTERVAL 1000    // ms between chunks
+#define REPAIR_PASS_INTERVAL 21600000 // ms between full passes
+
+// Reason column of mod_reagent_bank_account_quarantine. Every event is its
+// own row; rows of reason 1 and 2 hold reagents that can be restored, rows
+// of reason 3 only record what was missing.
+enum ReagentBankQuarantineReason : uint8
+{
+  QUARANTINE_UNKNOWN_ITEM = 1,   // item_entry has no item template
+  QUARANTINE_ORPHANED_GUID = 2,  // per-character row of a purged character
+  QUARANTINE_DEBIT_SHORTFALL = 3 // ledger debit above the stored amount;
+                                 // amount is the part that was missing
+};
+
+// Background consistency checker for mod_reagent_bank_account. Walks the
+// table in primary key chunks and validates every row against the item
+// catalog and the characters table:
+//  - amount <= 0 rows are deleted
+//  - rows of unknown items or purged characters are moved to
+//    mod_reagent_bank_account_quarantine
+//  - item_subclass is corrected to the template's category
+// Each chunk is repaired in one short transaction and owners that are in
+// use are left for the next pass. Counts are logged at the end of a pass,
+// together with the ledger debits quarantined as shortfalls since the
+// previous one.
+class ReagentBankRepair
+{
+public:
+  static ReagentBankRepair *instance();
+
+  // Drives the job (world thread)
+  void Update(uint32 diff);
+
+private:
+  void OnChunkLoaded(QueryResult result);
+
+  struct Counts
+  {
+    uint32 scanned = 0;
+    uint32 nonPositive = 0;
+    uint32 unknownItems = 0;
+    uint32 subclassFixed = 0;
+    uint32 orphaned = 0;
+    uint32 skippedInUse = 0;
+  };
+
+  QueryCallbackProcessor m_queryProcessor;
+  bool m_chunkInFlight = false;
+  bool m_passRunning = false;
+  uint32 m_timer = 0;
+  uint32 m_cursorAccount = 0; // Keyset cursor: last row examined
+  uint32 m_cursorGuid = 0;
+  uint32 m_cursorItem = 0;
+  uint32 m_shortfallsReported = 0; // Shortfalls before this time are logged
+  Counts m_counts;
+};
+
+#define sReagentBankRepair ReagentBankRepair::instance()
+
+#endif // AZEROTHCORE_REAGENTBANKREPAIR_H
@@ -0,0 +1,353 @@
+#include "ReagentBankTransfer.h"
+#include "DatabaseEnv.h"
+#include "Log.h"
+#include "ReagentBankAccount.h"
+#include "ReagentBankLedger.h"
+#include "StringConvert.h"
+#include "StringFormat.h"
+#include "Tokenize.h"
+#include <filesystem>
+#include <sstream>
+
+ReagentBankTransfer *ReagentBankTransfer::instance()
+{
+  static ReagentBankTransfer instance;
+  return &instance;
+}
+
+// Maps a file name from a command to a path inside the transfer directory
+bool ReagentBankTransfer::ResolvePath(std::string const &name,
+                                      bool forWriting, std::string &path,
+                                      std::string &message)
+{
+  std::filesystem::path relative(name);
+  if (name.empty() || relative.has_root_name() || relative.has_root_directory())
+  {
+    message = "Give a file name relative to ReagentBankAccount.Transfer.Directory.";
+    return false;
+  }
+  for (std::filesystem::path const &part : relative)
+  {
+    if (part == "..")
+    {
+      message = "File names may not contain \"..\".";
+      return false;
+    }
+  }
+  std::filesystem::path directory(
+      GetReagentBankSettings()->transferDirectory);
+  std::error_code error;
+  if (forWriting)
+    std::filesystem::create_directories(directory, error);
+  path = (directory / relative).lexically_normal().string();
+  return true;
+}
+
+bool ReagentBankTransfer::StartExport(std::string const &name, bool filtered,
+                                      uint32 accountKey, uint32 guidKey,
+                                      std::string &message)
+{
+  if (m_job != JOB_NONE)
+  {
+    message = "A transfer is already running. " + GetStatus();
+    return false;
+  }
+  std::string path;
+  if (!ResolvePath(name, true, path, message))
+    return false;
+  m_out.open(path, std::ios::out | std::ios::trunc);
+  if (!m_out)
+  {
+    message = "Cannot open " + path + " for writing.";
+    return false;
+  }
+  m_out << TRANSFER_FILE_HEADER << ' ' << TRANSFER_FILE_VERSION << '\n';
+  // Changes made before the export started are part of it
+  if (filtered)
+    sReagentBankLedger->FlushOwner(accountKey, guidKey);
+  else
+    sReagentBankLedger->Flush();
+  m_waitingForLedger = !filtered;
+  m_job = JOB_EXPORT;
+  m_path = path;
+  m_rows = 0;
+  m_badRows = 0;
+  m_outOfRangeRows = 0;
+  m_filtered = filtered;
+  m_cursorAccount = filtered ? accountKey : 0;
+  m_cursorGuid = filtered ? guidKey : 0;
+  m_cursorItem = 0;
+  message = "Export to " + path + " started.";
+  return true;
+}
+
+bool ReagentBankTransfer::StartImport(std::string const &name,
+                                      ReagentBankKeyRemap const &remap,
+                                      std::string &message)
+{
+  if (m_job != JOB_NONE)
+  {
+    message = "A transfer is already running. " + GetStatus();
+    return false;
+  }
+  if (remap.accountOffset >= GUILD_OWNER_FLAG ||
+      remap.guidOffset >= GUILD_OWNER_FLAG ||
+      remap.guildOffset >= GUILD_OWNER_FLAG)
+  {
+    message = Acore::StringFormat("Offsets must be below {}.",
+                                  GUILD_OWNER_FLAG);
+    return false;
+  }
+  std::string path;
+  if (!ResolvePath(name, false, path, message))
+    return false;
+  m_in.open(path);
+  std::string header;
+  if (!m_in || !std::getline(m_in, header))
+  {
+    m_in.close();
+    message = "Cannot read " + path + ".";
+    return false;
+  }
+  if (header != Acore::StringFormat("{} {}", TRANSFER_FILE_HEADER,
+                                    TRANSFER_FILE_VERSION))
+  {
+    m_in.close();
+    message = "Unsupported file format: " + header;
+    return false;
+  }
+  m_job = JOB_IMPORT;
+  m_path = path;
+  m_rows = 0;
+  m_badRows = 0;
+  m_outOfRangeRows = 0;
+  m_lines = 0;
+  m_sawTrailer = false;
+  m_remap = remap;
+  message = "Import from " + path + " started.";
+  return true;
+}
+
+std::string ReagentBankTransfer::GetStatus() const
+{
+  if (m_job == JOB_EXPORT)
+    return Acore::StringFormat("Exporting to {}: {} rows written.", m_path,
+                               m_rows);
+  if (m_job == JOB_IMPORT)
+    return Acore::StringFormat(
+        "Importing from {}: {} rows merged, {} malformed lines and {} rows "
+        "with out of range keys skipped.",
+        m_path, m_rows, m_badRows, m_outOfRangeRows);
+  return m_lastResult.empty() ? "No transfer has run." : m_lastResult;
+}
+
+void ReagentBankTransfer::Update(uint32 /*diff*/)
+{
+  m_queryProcessor.ProcessReadyCallbacks();
+  m_transactionProcessor.ProcessReadyCallbacks();
+  if (m_job == JOB_NONE || m_chunkInFlight)
+    return;
+  if (m_job == JOB_EXPORT)
+  {
+    if (m_waitingForLedger && sReagentBankLedger->HasWritesInFlight())
+      return;
+    m_waitingForLedger = false;
+    RequestExportChunk();
+  }
+  else
+    ImportChunk();
+}
+
+void ReagentBankTransfer::Finish(std::string const &result)
+{
+  m_out.close();
+  m_in.close();
+  m_job = JOB_NONE;
+  m_lastResult = result;
+  LOG_INFO("module", "ReagentBankAccount: {}", result);
+}
+
+// Merges the next page of both tables by key. Each side is limited to a
+// page on its own, which always covers the first page of the merged stream;
+// a key present in both tables is exported once with the amounts summed.
+void ReagentBankTransfer::RequestExportChunk()
+{
+  std::string account = std::to_string(m_cursorAccount);
+  std::string guid = std::to_string(m_cursorGuid);
+  std::string where =
+      m_filtered ? "account_id = " + account + " AND guid = " + guid +
+                       " AND item_entry > " + std::to_string(m_cursorItem)
+                 : "account_id > " + account + " OR (account_id = " +
+                       account + " AND (guid > " + guid + " OR (guid = " +
+                       guid + " AND item_entry > " +
+                       std::to_string(m_cursorItem) + ")))";
+  std::string page = " WHERE " + where +
+                     " ORDER BY account_id, guid, item_entry LIMIT " +
+                     std::to_string(TRANSFER_CHUNK_ROWS);
+  m_chunkInFlight = true;
+  m_queryProcessor.AddCallback(
+      CharacterDatabase
+          .AsyncQuery("SELECT account_id, guid, item_entry, MAX(item_subclass), SUM(amount) FROM ("
+                      "(SELECT account_id, guid, item_entry, item_subclass, amount FROM mod_reagent_bank_account" +
+                      page +
+                      ") UNION ALL (SELECT account_id, guid, item_entry, item_subclass, amount FROM mod_reagent_bank_account_cold" +
+                      page +
+                      ")) t GROUP BY account_id, guid, item_entry ORDER BY account_id, guid, item_entry LIMIT " +
+                      std::to_string(TRANSFER_CHUNK_ROWS))
+          .WithCallback([this](QueryResult result)
+                        { OnExportChunkLoaded(result); }));
+}
+
+void ReagentBankTransfer::OnExportChunkLoaded(QueryResult result)
+{
+  m_chunkInFlight = false;
+  uint32 rows = 0;
+  if (result)
+  {
+    do
+    {
+      Field *fields = result->Fetch();
+      m_cursorAccount = fields[0].Get<uint32>();
+      m_cursorGuid = fields[1].Get<uint32>();
+      m_cursorItem = fields[2].Get<uint32>();
+      m_out << m_cursorAccount << '\t' << m_cursorGuid << '\t' << m_cursorItem
+            << '\t' << fields[3].Get<uint32>() << '\t'
+            << fields[4].Get<int32>() << '\n';
+      ++rows;
+    } while (result->NextRow());
+    m_rows += rows;
+  }
+  if (!m_out)
+  {
+    Finish("Export to " + m_path + " failed: write error.");
+    return;
+  }
+  if (rows == TRANSFER_CHUNK_ROWS)
+    return;
+  m_out << "END " << m_rows << '\n';
+  m_out.flush();
+  Finish(Acore::StringFormat("Export to {} finished: {} rows.", m_path,
+                             m_rows));
+}
+
+// Adds an offset to a non-zero key; false if the result would not fit the
+// 31 bits below GUILD_OWNER_FLAG (the guid column is signed as well)
+static bool OffsetKey(uint32 key, uint32 offset, uint32 &result)
+{
+  uint64 sum = key ? uint64(key) + offset : 0;
+  if (sum >= GUILD_OWNER_FLAG)
+    return false;
+  result = uint32(sum);
+  return true;
+}
+
+bool ReagentBankTransfer::RemapKeys(uint32 accountKey, uint32 guidKey,
+                                    uint32 &account, uint32 &guid) const
+{
+  if (!OffsetKey(guidKey, m_remap.guidOffset, guid))
+    return false;
+  if (!IsGuildOwnerKey(accountKey))
+    return OffsetKey(accountKey, m_remap.accountOffset, account);
+  if (!OffsetKey(accountKey & ~GUILD_OWNER_FLAG, m_remap.guildOffset, account))
+    return false;
+  account |= GUILD_OWNER_FLAG;
+  return true;
+}
+
+// Reads up to TRANSFER_CHUNK_ROWS lines and merges them in one transaction
+void ReagentBankTransfer::ImportChunk()
+{
+  auto trans = CharacterDatabase.BeginTransaction();
+  std::set<std::pair<uint32, uint32>> owners;
+  std::ostringstream ss;
+  uint32 statementRows = 0;
+  uint32 rows = 0;
+  std::string line;
+  while (rows < TRANSFER_CHUNK_ROWS && !m_sawTrailer &&
+         std::getline(m_in, line))
+  {
+    std::vector<std::string_view> tokens = Acore::Tokenize(line, '\t', false);
+    if (tokens.size() == 1 && line.rfind("END ", 0) == 0)
+    {
+      m_sawTrailer = true;
+      Optional<uint64> count = Acore::StringTo<uint64>(line.substr(4));
+      if (!count || *count != m_lines)
+        LOG_WARN("module",
+                 "ReagentBankAccount: {} declares {} rows but has {}",
+                 m_path, line.substr(4), m_lines);
+      break;
+    }
+    ++m_lines;
+    Optional<uint32> accountKey, guidKey, itemEntry, itemSubclass;
+    Optional<int32> amount;
+    if (tokens.size() == 5)
+    {
+      accountKey = Acore::StringTo<uint32>(tokens[0]);
+      guidKey = Acore::StringTo<uint32>(tokens[1]);
+      itemEntry = Acore::StringTo<uint32>(tokens[2]);
+      itemSubclass = Acore::StringTo<uint32>(tokens[3]);
+      amount = Acore::StringTo<int32>(tokens[4]);
+    }
+    if (!accountKey || !guidKey || !itemEntry || !itemSubclass || !amount ||
+        *amount <= 0)
+    {
+      ++m_badRows;
+      continue;
+    }
+    uint32 account, guid;
+    if (!RemapKeys(*accountKey, *guidKey, account, guid))
+    {
+      ++m_outOfRangeRows;
+      continue;
+    }
+    ss << (statementRows == 0 ? "INSERT INTO mod_reagent_bank_account (account_id, guid, item_entry, item_subclass, amount) VALUES "
+                              : ", ")
+       << "(" << account << ", " << guid << ", " << *itemEntry << ", "
+       << *itemSubclass << ", " << *amount << ")";
+    owners.emplace(account, guid);
+    ++rows;
+    if (++statementRows == LEDGER_ROWS_PER_STATEMENT)
+    {
+      ss << " ON DUPLICATE KEY UPDATE amount = amount + VALUES(amount)";
+      trans->Append(ss.str());
+      ss.str("");
+      statementRows = 0;
+    }
+  }
+  if (statementRows > 0)
+  {
+    ss << " ON DUPLICATE KEY UPDATE amount = amount + VALUES(amount)";
+    trans->Append(ss.str());
+  }
+  if (rows == 0)
+  {
+    Finish(Acore::StringFormat(
+        "Import from {} finished: {} rows merged, {} malformed lines and {} "
+        "rows with out of range keys skipped{}.",
+        m_path, m_rows, m_badRows, m_outOfRangeRows,
+        m_sawTrailer ? "" : ", file has no END line (truncated?)"));
+    return;
+  }
+  m_rows += rows;
+  m_chunkInFlight = true;
+  m_transactionProcessor
+      .AddCallback(CharacterDatabase.AsyncCommitTransaction(trans))
+      .AfterComplete([this, owners](bool success)
+                     { OnImportChunkCommitted(success, owners); });
+}
+
+void ReagentBankTransfer::OnImportChunkCommitted(
+    bool success, std::set<std::pair<uint32, uint32>> owners)
+{
+  m_chunkInFlight = false;
+  if (!success)
+  {
+    Finish(Acore::StringFormat(
+        "Import from {} stopped: a chunk failed to commit after {} lines.",
+        m_path, m_lines));
+    return;
+  }
+  // Online owners that received rows see them without relogging
+  for (auto const &[accountKey, guidKey] : owners)
+    sReagentBankLedger->ReloadOwner(accountKey, guidKey);
+}
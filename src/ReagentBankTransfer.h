@@ -0,0 +1,106 @@
+#ifndef AZEROTHCORE_REAGENTBANKTRANSFER_H
+#define AZEROTHCORE_REAGENTBANKTRANSFER_H
+#include "AsyncCallbackProcessor.h"
+#include "DatabaseEnvFwd.h"
+#include "Define.h"
+#include <fstream>
+#include <set>
+#include <string>
+#include <utility>
+
+#define TRANSFER_FILE_HEADER "REAGENTBANK" // First token of an export file
+#define TRANSFER_FILE_VERSION 1
+#define TRANSFER_CHUNK_ROWS 10000 // Rows read or imported per chunk
+
+// Key remapping applied on import; an offset is added to every non-zero key
+// of its kind. Remapped keys must stay below GUILD_OWNER_FLAG; rows whose
+// keys would not are skipped and counted.
+struct ReagentBankKeyRemap
+{
+  uint32 accountOffset = 0;
+  uint32 guidOffset = 0;
+  uint32 guildOffset = 0;
+};
+
+// Streaming export and import of reagent bank rows for backups and realm
+// merges, started with .reagentbank export/import. File names are relative
+// to ReagentBankAccount.Transfer.Directory; absolute paths and ".." are
+// rejected, so the commands cannot touch files outside it. Both run in the
+// background one chunk at a time, so memory stays bounded however large the
+// table is:
+//  - export first writes the ledger's pending changes, then pages through
+//    the hot and archive tables as one stream ordered by primary key (each
+//    page is read in one statement, so rows moved between the tables by
+//    archival or rehydration are exported exactly once) and appends each
+//    page to the file
+//  - import reads the file a chunk at a time, remaps the keys and merges the
+//    amounts with multi-row additive upserts, waiting for each chunk to
+//    commit before reading the next
+//
+// File format (text, one row per line, tab separated):
+//   REAGENTBANK <version>
+//   <account_id> <guid> <item_entry> <item_subclass> <amount>
+//   ...
+//   END <row count>
+class ReagentBankTransfer
+{
+public:
+  static ReagentBankTransfer *instance();
+
+  // Exports every owner, or only the given owner key
+  bool StartExport(std::string const &name, bool filtered, uint32 accountKey,
+                   uint32 guidKey, std::string &message);
+  bool StartImport(std::string const &name, ReagentBankKeyRemap const &remap,
+                   std::string &message);
+  std::string GetStatus() const;
+
+  // Drives the running job (world thread)
+  void Update(uint32 diff);
+
+private:
+  enum Job : uint8
+  {
+    JOB_NONE,
+    JOB_EXPORT,
+    JOB_IMPORT
+  };
+
+  void RequestExportChunk();
+  void OnExportChunkLoaded(QueryResult result);
+  void ImportChunk();
+  void OnImportChunkCommitted(bool success,
+                              std::set<std::pair<uint32, uint32>> owners);
+  void Finish(std::string const &result);
+  static bool ResolvePath(std::string const &name, bool forWriting,
+                          std::string &path, std::string &message);
+  bool RemapKeys(uint32 accountKey, uint32 guidKey, uint32 &account,
+                 uint32 &guid) const;
+
+  QueryCallbackProcessor m_queryProcessor;
+  AsyncCallbackProcessor<TransactionCallback> m_transactionProcessor;
+  Job m_job = JOB_NONE;
+  bool m_chunkInFlight = false;
+  std::string m_path;
+  std::ofstream m_out;
+  std::ifstream m_in;
+  uint64 m_rows = 0;      // Rows exported or imported so far
+  uint64 m_badRows = 0;   // Import lines that could not be parsed
+  uint64 m_outOfRangeRows = 0; // Import rows whose remapped keys overflow
+  std::string m_lastResult;
+
+  // Export: owner filter and keyset cursor
+  bool m_filtered = false;
+  bool m_waitingForLedger = false; // Pending changes are still being written
+  uint32 m_cursorAccount = 0;
+  uint32 m_cursorGuid = 0;
+  uint32 m_cursorItem = 0;
+
+  // Import
+  ReagentBankKeyRemap m_remap;
+  uint64 m_lines = 0; // Data lines read
+  bool m_sawTrailer = false;
+};
+
+#define sReagentBankTransfer ReagentBankTransfer::instance()
+
+#endif // AZEROTHCORE_REAGENTBANKTRANSFER_H